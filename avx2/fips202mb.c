@@ -0,0 +1,192 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include <string.h>
+#include "fips202.h"
+#include "fips202x4.h"
+#include "fips202mb.h"
+
+/* Use implementation from the Keccak Code Package */
+#define KeccakF1600_StatePermute4x FIPS202X4_NAMESPACE(KeccakP1600times4_PermuteAll_24rounds)
+extern void KeccakF1600_StatePermute4x(__m256i *s);
+
+/* Multi-buffer SHAKE: runs a queue of independent jobs with arbitrary input
+ * and output lengths through up to four Keccak lanes.
+ *
+ * Every lane is a small state machine that absorbs one block of its input
+ * per permutation and, after the padded last block, squeezes one block of
+ * output per permutation. A lane whose job is done is refilled from the
+ * queue right away, so jobs of different lengths do not wait for each other.
+ * Active lanes are kept at the lowest indices; each step permutes them with
+ * the 4-way AVX2 Keccak, or with the scalar one when a single lane is left. */
+
+#define MAXLANES 4
+
+/* Lane j of word i is q[i][j], the layout of KeccakF1600_StatePermute4x */
+typedef union {
+  __m256i v[25];
+  uint64_t q[25][MAXLANES];
+} keccakmb_state;
+
+typedef struct {
+  shake_job job;
+  int squeezing;
+} lane;
+
+static uint64_t load64(const uint8_t x[8]) {
+  uint64_t r;
+  memcpy(&r, x, 8);
+  return r;
+}
+
+static void lane_load(keccakmb_state *s, unsigned int j, lane *l, const shake_job *job)
+{
+  unsigned int i;
+
+  for(i = 0; i < 25; ++i)
+    s->q[i][j] = 0;
+  l->job = *job;
+  l->squeezing = 0;
+}
+
+static void lane_move(keccakmb_state *s, unsigned int to, unsigned int from, lane *lanes)
+{
+  unsigned int i;
+
+  for(i = 0; i < 25; ++i)
+    s->q[i][to] = s->q[i][from];
+  lanes[to] = lanes[from];
+}
+
+/* Absorbs the next block of a lane, or its padded last block */
+static void lane_absorb(keccakmb_state *s, unsigned int j, lane *l, unsigned int r, uint8_t p)
+{
+  unsigned int i;
+  uint8_t t[8] = {0};
+  shake_job *job = &l->job;
+
+  if(job->inlen >= r) {
+    for(i = 0; i < r/8; ++i)
+      s->q[i][j] ^= load64(job->in + 8*i);
+    job->in += r;
+    job->inlen -= r;
+    return;
+  }
+
+  for(i = 0; i < job->inlen/8; ++i)
+    s->q[i][j] ^= load64(job->in + 8*i);
+  memcpy(t, job->in + 8*i, job->inlen - 8*i);
+  t[job->inlen - 8*i] = p;
+  s->q[i][j] ^= load64(t);
+  s->q[r/8 - 1][j] ^= 1ULL << 63;
+  l->squeezing = 1;
+}
+
+/* Copies up to one block of output; returns the number of bytes left */
+static size_t lane_squeeze(const keccakmb_state *s, unsigned int j, lane *l, unsigned int r)
+{
+  unsigned int i, n;
+  uint64_t t;
+  shake_job *job = &l->job;
+
+  n = (job->outlen < r) ? (unsigned int)job->outlen : r;
+  for(i = 0; i < n/8; ++i) {
+    t = s->q[i][j];
+    memcpy(job->out + 8*i, &t, 8);
+  }
+  if(n % 8) {
+    t = s->q[i][j];
+    memcpy(job->out + 8*i, &t, n % 8);
+  }
+  job->out += n;
+  job->outlen -= n;
+  return job->outlen;
+}
+
+static void permute(keccakmb_state *s, unsigned int nlanes)
+{
+  unsigned int i;
+  uint64_t s1[25];
+
+  if(nlanes > 1) {
+    KeccakF1600_StatePermute4x(s->v);
+  }
+  else {
+    for(i = 0; i < 25; ++i)
+      s1[i] = s->q[i][0];
+    KeccakF1600_StatePermute(s1);
+    for(i = 0; i < 25; ++i)
+      s->q[i][0] = s1[i];
+  }
+}
+
+/*************************************************
+* Name:        keccak_mb
+*
+* Description: Runs all jobs through the lane scheduler
+*
+* Arguments:   - const shake_job *jobs: array of jobs
+*              - size_t njobs: number of jobs
+*              - unsigned int r: rate in bytes (e.g., 168 for SHAKE128)
+*              - uint8_t p: domain-separation byte for different Keccak-derived functions
+**************************************************/
+static void keccak_mb(const shake_job *jobs, size_t njobs, unsigned int r, uint8_t p)
+{
+  unsigned int j, nlanes = 0;
+  size_t next = 0;
+  lane lanes[MAXLANES];
+  keccakmb_state s;
+
+  for(;;) {
+    while(nlanes < MAXLANES && next < njobs) {
+      if(jobs[next].outlen > 0) {
+        lane_load(&s, nlanes, &lanes[nlanes], &jobs[next]);
+        nlanes++;
+      }
+      next++;
+    }
+    if(nlanes == 0)
+      break;
+
+    for(j = 0; j < nlanes; ++j)
+      if(!lanes[j].squeezing)
+        lane_absorb(&s, j, &lanes[j], r, p);
+
+    permute(&s, nlanes);
+
+    for(j = 0; j < nlanes;) {
+      if(lanes[j].squeezing && lane_squeeze(&s, j, &lanes[j], r) == 0)
+        lane_move(&s, j, --nlanes, lanes);
+      else
+        ++j;
+    }
+  }
+}
+
+/*************************************************
+* Name:        shake128_mb
+*
+* Description: SHAKE128 of a batch of independent inputs with individual
+*              output lengths
+*
+* Arguments:   - const shake_job *jobs: array of jobs
+*              - size_t njobs: number of jobs
+**************************************************/
+void shake128_mb(const shake_job *jobs, size_t njobs)
+{
+  keccak_mb(jobs, njobs, SHAKE128_RATE, 0x1F);
+}
+
+/*************************************************
+* Name:        shake256_mb
+*
+* Description: SHAKE256 of a batch of independent inputs with individual
+*              output lengths
+*
+* Arguments:   - const shake_job *jobs: array of jobs
+*              - size_t njobs: number of jobs
+**************************************************/
+void shake256_mb(const shake_job *jobs, size_t njobs)
+{
+  keccak_mb(jobs, njobs, SHAKE256_RATE, 0x1F);
+}
@@ -0,0 +1,23 @@
+#ifndef FIPS202MB_H
+#define FIPS202MB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FIPS202MB_NAMESPACE(s) pqcrystals_kyber_fips202mb_avx2_##s
+
+/* One independent hash: outlen bytes of SHAKE(in) are written to out */
+typedef struct {
+  const uint8_t *in;
+  size_t inlen;
+  uint8_t *out;
+  size_t outlen;
+} shake_job;
+
+#define shake128_mb FIPS202MB_NAMESPACE(shake128_mb)
+void shake128_mb(const shake_job *jobs, size_t njobs);
+
+#define shake256_mb FIPS202MB_NAMESPACE(shake256_mb)
+void shake256_mb(const shake_job *jobs, size_t njobs);
+
+#endif
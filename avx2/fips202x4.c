@@ -198,3 +198,24 @@ void shake256x4(uint8_t *out0,
     }
   }
 }
+
+void sha3_512x4(uint8_t *out0,
+                uint8_t *out1,
+                uint8_t *out2,
+                uint8_t *out3,
+                const uint8_t *in0,
+                const uint8_t *in1,
+                const uint8_t *in2,
+                const uint8_t *in3,
+                size_t inlen)
+{
+  uint8_t t[4][SHA3_512_RATE];
+  __m256i s[25];
+
+  keccakx4_absorb_once(s, SHA3_512_RATE, in0, in1, in2, in3, inlen, 0x06);
+  keccakx4_squeezeblocks(t[0], t[1], t[2], t[3], 1, SHA3_512_RATE, s);
+  memcpy(out0, t[0], 64);
+  memcpy(out1, t[1], 64);
+  memcpy(out2, t[2], 64);
+  memcpy(out3, t[3], 64);
+}
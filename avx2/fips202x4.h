@@ -67,4 +67,15 @@ void shake256x4(uint8_t *out0,
                 const uint8_t *in3,
                 size_t inlen);
 
+#define sha3_512x4 FIPS202X4_NAMESPACE(sha3_512x4)
+void sha3_512x4(uint8_t *out0,
+                uint8_t *out1,
+                uint8_t *out2,
+                uint8_t *out3,
+                const uint8_t *in0,
+                const uint8_t *in1,
+                const uint8_t *in2,
+                const uint8_t *in3,
+                size_t inlen);
+
 #endif
@@ -5,27 +5,13 @@
 #define KYBER_K 3	/* Change this for different security strengths */
 #endif
 
-//#define KYBER_90S	/* Uncomment this if you want the 90S variant */
-
 /* Don't change parameters below this line */
 #if   (KYBER_K == 2)
-#ifdef KYBER_90S
-#define KYBER_NAMESPACE(s) pqcrystals_kyber512_90s_avx2_##s
-#else
 #define KYBER_NAMESPACE(s) pqcrystals_kyber512_avx2_##s
-#endif
 #elif (KYBER_K == 3)
-#ifdef KYBER_90S
-#define KYBER_NAMESPACE(s) pqcrystals_kyber768_90s_avx2_##s
-#else
 #define KYBER_NAMESPACE(s) pqcrystals_kyber768_avx2_##s
-#endif
 #elif (KYBER_K == 4)
-#ifdef KYBER_90S
-#define KYBER_NAMESPACE(s) pqcrystals_kyber1024_90s_avx2_##s
-#else
 #define KYBER_NAMESPACE(s) pqcrystals_kyber1024_avx2_##s
-#endif
 #else
 #error "KYBER_K must be in {2,3,4}"
 #endif
@@ -64,5 +50,7 @@
 /* 32 bytes of additional space to save H(pk) */
 #define KYBER_SECRETKEYBYTES  (KYBER_INDCPA_SECRETKEYBYTES + KYBER_INDCPA_PUBLICKEYBYTES + 2*KYBER_SYMBYTES)
 #define KYBER_CIPHERTEXTBYTES (KYBER_INDCPA_BYTES)
+/* coins of crypto_kem_keypair_derand, from which a key pair is regenerated */
+#define KYBER_SEEDKEYBYTES    (2*KYBER_SYMBYTES)
 
 #endif
@@ -311,7 +311,6 @@ void poly_getnoise_eta2(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t non
   poly_cbd_eta2(r, buf.vec);
 }
 
-#ifndef KYBER_90S
 #define NOISE_NBLOCKS ((KYBER_ETA1*KYBER_N/4+SHAKE256_RATE-1)/SHAKE256_RATE)
 void poly_getnoise_eta1_4x(poly *r0,
                            poly *r1,
@@ -347,42 +346,51 @@ void poly_getnoise_eta1_4x(poly *r0,
   poly_cbd_eta1(r3, buf[3].vec);
 }
 
-#if KYBER_K == 2
-void poly_getnoise_eta1122_4x(poly *r0,
-                              poly *r1,
-                              poly *r2,
-                              poly *r3,
-                              const uint8_t seed[32],
-                              uint8_t nonce0,
-                              uint8_t nonce1,
-                              uint8_t nonce2,
-                              uint8_t nonce3)
+/*************************************************
+* Name:        poly_getnoise_mb
+*
+* Description: Samples n polynomials deterministically from a seed and
+*              consecutive nonces, all through one multi-buffer SHAKE256
+*              run; the first n1 with parameter KYBER_ETA1, the others with
+*              KYBER_ETA2. Lanes whose shorter eta2 output is done take the
+*              next job while the eta1 lanes still squeeze.
+*
+* Arguments:   - poly **r: array of n pointers to output polynomials
+*              - unsigned int n1: number of polynomials with KYBER_ETA1
+*              - unsigned int n: number of polynomials, at most 2*KYBER_K+1
+*              - const uint8_t *seed: pointer to input seed
+*                                     (of length KYBER_SYMBYTES bytes)
+*              - uint8_t nonce: nonce of r[0]; r[i] uses nonce+i
+**************************************************/
+void poly_getnoise_mb(poly *r[],
+                      unsigned int n1,
+                      unsigned int n,
+                      const uint8_t seed[KYBER_SYMBYTES],
+                      uint8_t nonce)
 {
-  ALIGNED_UINT8(NOISE_NBLOCKS*SHAKE256_RATE) buf[4];
-  __m256i f;
-  keccakx4_state state;
-
-  f = _mm256_loadu_si256((__m256i *)seed);
-  _mm256_store_si256(buf[0].vec, f);
-  _mm256_store_si256(buf[1].vec, f);
-  _mm256_store_si256(buf[2].vec, f);
-  _mm256_store_si256(buf[3].vec, f);
-
-  buf[0].coeffs[32] = nonce0;
-  buf[1].coeffs[32] = nonce1;
-  buf[2].coeffs[32] = nonce2;
-  buf[3].coeffs[32] = nonce3;
+  unsigned int i;
+  ALIGNED_UINT8(NOISE_NBLOCKS*SHAKE256_RATE) buf[2*KYBER_K+1];
+  uint8_t in[2*KYBER_K+1][KYBER_SYMBYTES+1];
+  shake_job jobs[2*KYBER_K+1] = {{0}};
+
+  for(i=0;i<n;i++) {
+    memcpy(in[i], seed, KYBER_SYMBYTES);
+    in[i][KYBER_SYMBYTES] = nonce+i;
+    jobs[i].in = in[i];
+    jobs[i].inlen = KYBER_SYMBYTES+1;
+    jobs[i].out = buf[i].coeffs;
+    jobs[i].outlen = (i < n1) ? KYBER_ETA1*KYBER_N/4 : KYBER_ETA2*KYBER_N/4;
+  }
 
-  shake256x4_absorb_once(&state, buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, 33);
-  shake256x4_squeezeblocks(buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, NOISE_NBLOCKS, &state);
+  shake256_mb(jobs, n);
 
-  poly_cbd_eta1(r0, buf[0].vec);
-  poly_cbd_eta1(r1, buf[1].vec);
-  poly_cbd_eta2(r2, buf[2].vec);
-  poly_cbd_eta2(r3, buf[3].vec);
+  for(i=0;i<n;i++) {
+    if(i < n1)
+      poly_cbd_eta1(r[i], buf[i].vec);
+    else
+      poly_cbd_eta2(r[i], buf[i].vec);
+  }
 }
-#endif
-#endif
 
 /*************************************************
 * Name:        poly_ntt
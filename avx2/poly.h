@@ -28,7 +28,6 @@ void poly_getnoise_eta1(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t non
 #define poly_getnoise_eta2 KYBER_NAMESPACE(poly_getnoise_eta2)
 void poly_getnoise_eta2(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t nonce);
 
-#ifndef KYBER_90S
 #define poly_getnoise_eta1_4x KYBER_NAMESPACE(poly_getnoise_eta2_4x)
 void poly_getnoise_eta1_4x(poly *r0,
                            poly *r1,
@@ -40,19 +39,12 @@ void poly_getnoise_eta1_4x(poly *r0,
                            uint8_t nonce2,
                            uint8_t nonce3);
 
-#if KYBER_K == 2
-#define poly_getnoise_eta1122_4x KYBER_NAMESPACE(poly_getnoise_eta1122_4x)
-void poly_getnoise_eta1122_4x(poly *r0,
-                              poly *r1,
-                              poly *r2,
-                              poly *r3,
-                              const uint8_t seed[32],
-                              uint8_t nonce0,
-                              uint8_t nonce1,
-                              uint8_t nonce2,
-                              uint8_t nonce3);
-#endif
-#endif
+#define poly_getnoise_mb KYBER_NAMESPACE(poly_getnoise_mb)
+void poly_getnoise_mb(poly *r[],
+                      unsigned int n1,
+                      unsigned int n,
+                      const uint8_t seed[KYBER_SYMBYTES],
+                      uint8_t nonce);
 
 
 #define poly_ntt KYBER_NAMESPACE(poly_ntt)
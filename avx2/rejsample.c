@@ -271,7 +271,14 @@ static const uint8_t idx[256][8] = {
 #define _mm256_cmpge_epu16(a, b) _mm256_cmpeq_epi16(_mm256_max_epu16(a, b), a)
 #define _mm_cmpge_epu16(a, b) _mm_cmpeq_epi16(_mm_max_epu16(a, b), a)
 
-unsigned int rej_uniform_avx(int16_t * restrict r, const uint8_t *buf)
+/* Shared body of rej_uniform_avx and rej_uniform_avx_partial; inlined into
+ * both so that the full-buffer case keeps its constant loop bounds. Every
+ * vector store writes 8 coefficients, so the vector loops only run while
+ * that many still fit below len. */
+static inline unsigned int rej_uniform_avx_core(int16_t * restrict r,
+                                                unsigned int len,
+                                                const uint8_t *buf,
+                                                unsigned int buflen)
 {
   unsigned int ctr, pos;
   uint16_t val0, val1;
@@ -290,7 +297,7 @@ unsigned int rej_uniform_avx(int16_t * restrict r, const uint8_t *buf)
   __m128i f, t, pilo, pihi;
 
   ctr = pos = 0;
-  while(ctr <= KYBER_N - 32 && pos <= REJ_UNIFORM_AVX_BUFLEN - 56) {
+  while(ctr + 32 <= len && pos + 56 <= buflen) {
     f0 = _mm256_loadu_si256((__m256i *)&buf[pos]);
     f1 = _mm256_loadu_si256((__m256i *)&buf[pos+24]);
     f0 = _mm256_permute4x64_epi64(f0, 0x94);
@@ -354,7 +361,7 @@ unsigned int rej_uniform_avx(int16_t * restrict r, const uint8_t *buf)
     ctr += _mm_popcnt_u32((good >> 24) & 0xFF);
   }
 
-  while(ctr <= KYBER_N - 8 && pos <= REJ_UNIFORM_AVX_BUFLEN - 16) {
+  while(ctr + 8 <= len && pos + 16 <= buflen) {
     f = _mm_loadu_si128((__m128i *)&buf[pos]);
     f = _mm_shuffle_epi8(f, _mm256_castsi256_si128(idx8));
     t = _mm_srli_epi16(f, 4);
@@ -383,16 +390,56 @@ unsigned int rej_uniform_avx(int16_t * restrict r, const uint8_t *buf)
     ctr += _mm_popcnt_u32(good);
   }
 
-  while(ctr < KYBER_N && pos <= REJ_UNIFORM_AVX_BUFLEN - 3) {
+  while(ctr < len && pos + 3 <= buflen) {
     val0 = ((buf[pos+0] >> 0) | ((uint16_t)buf[pos+1] << 8)) & 0xFFF;
     val1 = ((buf[pos+1] >> 4) | ((uint16_t)buf[pos+2] << 4));
     pos += 3;
 
     if(val0 < KYBER_Q)
       r[ctr++] = val0;
-    if(val1 < KYBER_Q && ctr < KYBER_N)
+    if(val1 < KYBER_Q && ctr < len)
       r[ctr++] = val1;
   }
 
   return ctr;
 }
+
+/*************************************************
+* Name:        rej_uniform_avx
+*
+* Description: Run rejection sampling on REJ_UNIFORM_AVX_BUFLEN uniform
+*              random bytes to generate up to KYBER_N uniform random
+*              integers mod q
+*
+* Arguments:   - int16_t *r: pointer to output array of KYBER_N coefficients
+*              - const uint8_t *buf: pointer to input buffer
+*
+* Returns number of sampled 16-bit integers (at most KYBER_N)
+**************************************************/
+unsigned int rej_uniform_avx(int16_t * restrict r, const uint8_t *buf)
+{
+  return rej_uniform_avx_core(r, KYBER_N, buf, REJ_UNIFORM_AVX_BUFLEN);
+}
+
+/*************************************************
+* Name:        rej_uniform_avx_partial
+*
+* Description: Vectorized rejection sampling into a partially filled
+*              polynomial: samples at most len integers from buflen bytes.
+*              Used for the blocks squeezed after the first
+*              REJ_UNIFORM_AVX_NBLOCKS.
+*
+* Arguments:   - int16_t *r: pointer to output array (remaining capacity)
+*              - unsigned int len: remaining capacity of r
+*              - const uint8_t *buf: pointer to input buffer
+*              - unsigned int buflen: length of input buffer in bytes
+*
+* Returns number of sampled 16-bit integers (at most len)
+**************************************************/
+unsigned int rej_uniform_avx_partial(int16_t * restrict r,
+                                     unsigned int len,
+                                     const uint8_t *buf,
+                                     unsigned int buflen)
+{
+  return rej_uniform_avx_core(r, len, buf, buflen);
+}
@@ -10,5 +10,7 @@
 
 #define rej_uniform_avx KYBER_NAMESPACE(rej_uniform_avx)
 unsigned int rej_uniform_avx(int16_t *r, const uint8_t *buf);
+#define rej_uniform_avx_partial KYBER_NAMESPACE(rej_uniform_avx_partial)
+unsigned int rej_uniform_avx_partial(int16_t *r, unsigned int len, const uint8_t *buf, unsigned int buflen);
 
 #endif
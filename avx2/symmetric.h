@@ -7,6 +7,7 @@
 
 #include "fips202.h"
 #include "fips202x4.h"
+#include "fips202mb.h"
 
 typedef keccak_state xof_state;
 
@@ -22,6 +23,26 @@ void kyber_shake256_prf(uint8_t *out, size_t outlen, const uint8_t key[KYBER_SYM
 #define kyber_shake256_rkprf KYBER_NAMESPACE(kyber_shake256_rkprf)
 void kyber_shake256_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SYMBYTES], const uint8_t input[KYBER_CIPHERTEXTBYTES]);
 
+#define kyber_shake256_rkprf_init KYBER_NAMESPACE(kyber_shake256_rkprf_init)
+void kyber_shake256_rkprf_init(keccak_state *s, const uint8_t key[KYBER_SYMBYTES]);
+
+#define kyber_shake256_rkprf_final KYBER_NAMESPACE(kyber_shake256_rkprf_final)
+void kyber_shake256_rkprf_final(uint8_t out[KYBER_SSBYTES], const keccak_state *init, const uint8_t input[KYBER_CIPHERTEXTBYTES]);
+
+#define kyber_shake256_rkprf_x4 KYBER_NAMESPACE(kyber_shake256_rkprf_x4)
+void kyber_shake256_rkprf_x4(uint8_t *out0,
+                             uint8_t *out1,
+                             uint8_t *out2,
+                             uint8_t *out3,
+                             const uint8_t *key0,
+                             const uint8_t *key1,
+                             const uint8_t *key2,
+                             const uint8_t *key3,
+                             const uint8_t *input0,
+                             const uint8_t *input1,
+                             const uint8_t *input2,
+                             const uint8_t *input3);
+
 #define XOF_BLOCKBYTES SHAKE128_RATE
 
 #define hash_h(OUT, IN, INBYTES) sha3_256(OUT, IN, INBYTES)
@@ -30,5 +51,14 @@ void kyber_shake256_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SY
 #define xof_squeezeblocks(OUT, OUTBLOCKS, STATE) shake128_squeezeblocks(OUT, OUTBLOCKS, STATE)
 #define prf(OUT, OUTBYTES, KEY, NONCE) kyber_shake256_prf(OUT, OUTBYTES, KEY, NONCE)
 #define rkprf(OUT, KEY, INPUT) kyber_shake256_rkprf(OUT, KEY, INPUT)
+#define rkprf_init(STATE, KEY) kyber_shake256_rkprf_init(STATE, KEY)
+#define rkprf_final(OUT, STATE, INPUT) kyber_shake256_rkprf_final(OUT, STATE, INPUT)
+
+/* crypto_kem_dec_batch runs groups of four and hashes them 4-way */
+#define KYBER_DEC_BATCH 4
+#define hash_g_x4(OUT0, OUT1, OUT2, OUT3, IN0, IN1, IN2, IN3, INBYTES) \
+        sha3_512x4(OUT0, OUT1, OUT2, OUT3, IN0, IN1, IN2, IN3, INBYTES)
+#define rkprf_x4(OUT0, OUT1, OUT2, OUT3, KEY0, KEY1, KEY2, KEY3, IN0, IN1, IN2, IN3) \
+        kyber_shake256_rkprf_x4(OUT0, OUT1, OUT2, OUT3, KEY0, KEY1, KEY2, KEY3, IN0, IN1, IN2, IN3)
 
 #endif /* SYMMETRIC_H */
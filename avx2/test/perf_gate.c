@@ -0,0 +1 @@
+../../ref/test/perf_gate.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../ref/test/perf_gate.h
\ No newline at end of file
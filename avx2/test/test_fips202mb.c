@@ -0,0 +1,76 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../fips202.h"
+#include "../fips202mb.h"
+#include "../randombytes.h"
+
+#define MAXJOBS 16
+#define MAXLEN (3*SHAKE128_RATE+1)
+#define NTESTS 200
+
+static uint8_t in[MAXJOBS][MAXLEN];
+static uint8_t out[MAXJOBS][MAXLEN];
+static uint8_t ref[MAXLEN];
+
+/* Lengths around the block boundaries and random ones in between */
+static size_t length(unsigned int rate)
+{
+  uint8_t r[2];
+  static const unsigned int edge[] = {0, 1, 7, 8, 9};
+
+  randombytes(r, 2);
+  if(r[0] < 64)
+    return (r[1] % 3)*rate + edge[r[1] % 5] - ((r[1] % 3) && (r[0] & 1));
+  return ((size_t)r[0] << 8 | r[1]) % MAXLEN;
+}
+
+static int check(unsigned int rate, int x256)
+{
+  unsigned int i, t;
+  uint8_t n;
+  shake_job jobs[MAXJOBS];
+
+  for(t=0;t<NTESTS;t++) {
+    randombytes(&n, 1);
+    n %= MAXJOBS+1;
+    for(i=0;i<n;i++) {
+      jobs[i].inlen = length(rate);
+      jobs[i].outlen = length(rate);
+      randombytes(in[i], jobs[i].inlen);
+      jobs[i].in = in[i];
+      jobs[i].out = out[i];
+      memset(out[i], 0xAA, MAXLEN);
+    }
+
+    if(x256)
+      shake256_mb(jobs, n);
+    else
+      shake128_mb(jobs, n);
+
+    for(i=0;i<n;i++) {
+      memset(ref, 0xAA, MAXLEN);
+      if(x256)
+        shake256(ref, jobs[i].outlen, in[i], jobs[i].inlen);
+      else
+        shake128(ref, jobs[i].outlen, in[i], jobs[i].inlen);
+      if(memcmp(out[i], ref, MAXLEN)) {
+        printf("ERROR shake%s_mb job %u of %u (inlen %zu, outlen %zu)\n",
+               x256 ? "256" : "128", i, (unsigned int)n, jobs[i].inlen, jobs[i].outlen);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  if(check(SHAKE128_RATE, 0) || check(SHAKE256_RATE, 1))
+    return 1;
+
+  printf("fips202mb: %d batches OK\n", 2*NTESTS);
+  return 0;
+}
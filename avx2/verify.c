@@ -81,3 +81,21 @@ void cmov(uint8_t * restrict r, const uint8_t *x, size_t len, uint8_t b)
   for(i=0;i<len;i++)
     r[i] ^= -b & (x[i] ^ r[i]);
 }
+
+/*************************************************
+* Name:        wipe
+*
+* Description: Overwrite len bytes at p with zeros, e.g. secrets on the
+*              stack before returning; the volatile stores are not
+*              removed as dead by the compiler.
+*
+* Arguments:   void *p:    pointer to byte array
+*              size_t len: Amount of bytes to be cleared
+**************************************************/
+void wipe(void *p, size_t len)
+{
+  volatile uint8_t *v = p;
+
+  while(len--)
+    *v++ = 0;
+}
@@ -0,0 +1,148 @@
+"""Benchmark driver for the kyber512/kyber768/kyber1024 extension modules.
+
+Every operation is run a number of warm-up times and then timed over many
+repetitions, and the distribution of the samples is reported. The same
+measurement is taken for the *_noop variant of each call, which marshals
+arguments and results like the real call but skips the KEM, so the FFI
+overhead can be subtracted from the total.
+
+Build the modules first with `python3 setup.py build_ext --inplace`.
+"""
+
+import argparse
+import importlib
+import math
+import os
+import statistics
+
+import cycles
+
+LEVELS = {
+    "512": "kyber512",
+    "768": "kyber768",
+    "1024": "kyber1024",
+}
+
+# name -> (start read, stop read, unit); the raw TSC reads exist on x86 only
+TIMERS = {
+    "serialized": (cycles.start, cycles.stop, "ns" if cycles.SOURCE.startswith("clock") else "cycles"),
+    "ns": (cycles.clock_ns, cycles.clock_ns, "ns"),
+}
+if hasattr(cycles, "rdtsc"):
+    TIMERS["rdtsc"] = (cycles.rdtsc, cycles.rdtsc, "cycles")
+    TIMERS["rdtscp"] = (cycles.rdtscp, cycles.rdtscp, "cycles")
+    TIMERS["fenced"] = (cycles.rdtsc_fenced, cycles.rdtsc_fenced, "cycles")
+
+
+def percentile(sorted_samples, p):
+    """Nearest-rank percentile of an already sorted list."""
+    k = max(0, math.ceil(p / 100 * len(sorted_samples)) - 1)
+    return sorted_samples[k]
+
+
+def summarize(samples):
+    s = sorted(samples)
+    return {
+        "min": s[0],
+        "median": statistics.median(s),
+        "mean": statistics.fmean(s),
+        "stdev": statistics.stdev(s) if len(s) > 1 else 0.0,
+        "p90": percentile(s, 90),
+        "p99": percentile(s, 99),
+        "max": s[-1],
+    }
+
+
+def timer_overhead(start, stop, reps):
+    """Smallest observed difference between two back-to-back timer reads."""
+    best = None
+    for _ in range(reps):
+        t0 = start()
+        t1 = stop()
+        if best is None or t1 - t0 < best:
+            best = t1 - t0
+    return best
+
+
+def measure(fn, args, timer, warmup, reps, overhead):
+    start, stop = timer
+    for _ in range(warmup):
+        fn(*args)
+    samples = []
+    for _ in range(reps):
+        t0 = start()
+        fn(*args)
+        t1 = stop()
+        samples.append(max(0, t1 - t0 - overhead))
+    return samples
+
+
+def to_ns(samples):
+    return [round(cycles.to_ns(s)) for s in samples]
+
+
+def bench_level(kyber, timer, unit, warmup, reps, overhead, in_ns):
+    pk, sk = kyber.keypair()
+    ct, _ = kyber.enc(pk)
+
+    ops = [
+        ("keypair", kyber.keypair, kyber.keypair_noop, ()),
+        ("enc", kyber.enc, kyber.enc_noop, (pk,)),
+        ("dec", kyber.dec, kyber.dec_noop, (ct, sk)),
+    ]
+
+    print(f"\n== {kyber.ALGNAME} ({reps} reps, {warmup} warm-up, {unit}) ==")
+    print(f"{'operation':<14}{'min':>10}{'median':>10}{'mean':>10}{'stdev':>10}"
+          f"{'p90':>10}{'p99':>10}{'max':>10}")
+
+    for name, fn, noop, args in ops:
+        total = measure(fn, args, timer, warmup, reps, overhead)
+        ffi = measure(noop, args, timer, warmup, reps, overhead)
+        if in_ns:
+            total, ffi = to_ns(total), to_ns(ffi)
+        total, ffi = summarize(total), summarize(ffi)
+        for label, st in ((name, total), (name + " (ffi)", ffi)):
+            print(f"{label:<14}{st['min']:>10}{st['median']:>10.0f}{st['mean']:>10.0f}"
+                  f"{st['stdev']:>10.0f}{st['p90']:>10}{st['p99']:>10}{st['max']:>10}")
+        crypto = total["median"] - ffi["median"]
+        share = 100 * ffi["median"] / total["median"] if total["median"] else 0.0
+        print(f"{name + ' (kem)':<14}{'':>10}{crypto:>10.0f}"
+              f"   <- median minus FFI overhead ({share:.1f}% of the call)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--levels", nargs="+", choices=sorted(LEVELS), default=["512", "768", "1024"])
+    parser.add_argument("--reps", type=int, default=1000, help="timed repetitions per operation")
+    parser.add_argument("--warmup", type=int, default=100, help="untimed repetitions per operation")
+    parser.add_argument("--timer", choices=sorted(TIMERS), default="serialized")
+    parser.add_argument("--ns", action="store_true", help="report TSC timings in calibrated nanoseconds")
+    parser.add_argument("--cpu", type=int, help="pin the process to this CPU")
+    args = parser.parse_args()
+
+    if args.reps < 2:
+        parser.error("--reps must be at least 2")
+
+    if args.cpu is not None:
+        os.sched_setaffinity(0, {args.cpu})
+
+    start, stop, unit = TIMERS[args.timer]
+    if args.timer == "serialized":
+        overhead = cycles.overhead()
+    else:
+        overhead = timer_overhead(start, stop, 10000)
+    print(f"timer: {args.timer} ({cycles.SOURCE}), read overhead {overhead} {unit} "
+          f"(subtracted from every sample)")
+
+    in_ns = args.ns and unit == "cycles"
+    if in_ns:
+        print(f"calibrated counter: {cycles.calibrate():.3f} ticks/ns")
+        unit = "ns"
+
+    for level in args.levels:
+        kyber = importlib.import_module(LEVELS[level])
+        bench_level(kyber, (start, stop), unit, args.warmup, args.reps, overhead, in_ns)
+
+
+if __name__ == "__main__":
+    main()
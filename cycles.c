@@ -1,4 +1,17 @@
 #include <stdint.h>
+#include <time.h>
+
+// Portable fallback in nanoseconds
+static uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+#define HAVE_TSC 1
+#define COUNTER_SOURCE "tsc"
+
 #if defined(__i386__)
 
 // For 32-bit x86
@@ -8,7 +21,7 @@ static __inline__ uint64_t rdtsc(void) {
     return x;
 }
 
-#elif defined(__x86_64__)
+#else
 
 // For 64-bit x86
 static __inline__ uint64_t rdtsc(void) {
@@ -17,20 +30,205 @@ static __inline__ uint64_t rdtsc(void) {
     return ((uint64_t)lo) | (((uint64_t)hi) << 32);
 }
 
+#endif
+
+// rdtscp waits for all earlier instructions to retire before reading the
+// counter; later instructions may still start early
+static __inline__ uint64_t rdtscp(void) {
+    uint32_t hi, lo, aux;
+    __asm__ volatile ("rdtscp" : "=a"(lo), "=d"(hi), "=c"(aux) : : "memory");
+    return ((uint64_t)lo) | (((uint64_t)hi) << 32);
+}
+
+// lfence on both sides keeps rdtsc from being reordered with the code
+// being measured in either direction
+static __inline__ uint64_t rdtsc_fenced(void) {
+    uint32_t hi, lo;
+    __asm__ volatile ("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi) : : "memory");
+    return ((uint64_t)lo) | (((uint64_t)hi) << 32);
+}
+
+// Start of a measured region: earlier code has completed, and the region
+// cannot begin before the counter is read
+static __inline__ uint64_t counter_start(void) {
+    return rdtsc_fenced();
+}
+
+// End of a measured region: the region has completed, and later code
+// cannot begin before the counter is read
+static __inline__ uint64_t counter_stop(void) {
+    uint32_t hi, lo, aux;
+    __asm__ volatile ("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux) : : "memory");
+    return ((uint64_t)lo) | (((uint64_t)hi) << 32);
+}
+
+#else
+// No architecturally serialized user-space cycle counter (e.g. arm64):
+// count nanoseconds of the raw monotonic clock instead
+#define HAVE_TSC 0
+
+#ifdef CLOCK_MONOTONIC_RAW
+#define COUNTER_CLOCK CLOCK_MONOTONIC_RAW
+#define COUNTER_SOURCE "clock_monotonic_raw"
 #else
-#error "RDTSC not supported on this architecture"
+#define COUNTER_CLOCK CLOCK_MONOTONIC
+#define COUNTER_SOURCE "clock_monotonic"
+#endif
+
+static uint64_t counter_raw(void) {
+    struct timespec ts;
+    clock_gettime(COUNTER_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t counter_start(void) {
+    return counter_raw();
+}
+
+static uint64_t counter_stop(void) {
+    return counter_raw();
+}
+
 #endif
 
+// Cost of an empty start/stop pair; -1 until measured
+static uint64_t overhead = (uint64_t)-1;
+// Counter ticks per nanosecond; 0 until calibrated
+static double ticks_per_ns = 0;
+
+static uint64_t measure_overhead(void) {
+    unsigned int i;
+    uint64_t t0, t1, min = (uint64_t)-1;
+
+    for(i = 0; i < 100000; i++) {
+        t0 = counter_start();
+        t1 = counter_stop();
+        if(t1 - t0 < min)
+            min = t1 - t0;
+    }
+
+    return min;
+}
+
+// Busy-wait for about ns nanoseconds and compare the counter against the
+// monotonic clock
+static double measure_ticks_per_ns(uint64_t ns) {
+    uint64_t c0, c1, n0, n1;
+
+    if(!HAVE_TSC)
+        return 1.0;
+
+    n0 = clock_ns();
+    c0 = counter_start();
+    do {
+        n1 = clock_ns();
+    } while(n1 - n0 < ns);
+    c1 = counter_stop();
+
+    return (double)(c1 - c0) / (double)(n1 - n0);
+}
+
 #include <Python.h>
 
 // Python wrapper
+#if HAVE_TSC
 static PyObject* py_cycles(PyObject *self, PyObject *args) {
     uint64_t cycles = rdtsc();
     return PyLong_FromUnsignedLongLong(cycles);
 }
 
+static PyObject* py_rdtscp(PyObject *self, PyObject *args) {
+    uint64_t cycles = rdtscp();
+    return PyLong_FromUnsignedLongLong(cycles);
+}
+
+static PyObject* py_rdtsc_fenced(PyObject *self, PyObject *args) {
+    uint64_t cycles = rdtsc_fenced();
+    return PyLong_FromUnsignedLongLong(cycles);
+}
+#endif
+
+static PyObject* py_clock_ns(PyObject *self, PyObject *args) {
+    uint64_t ns = clock_ns();
+    return PyLong_FromUnsignedLongLong(ns);
+}
+
+static PyObject* py_start(PyObject *self, PyObject *args) {
+    uint64_t t = counter_start();
+    return PyLong_FromUnsignedLongLong(t);
+}
+
+static PyObject* py_stop(PyObject *self, PyObject *args) {
+    uint64_t t = counter_stop();
+    return PyLong_FromUnsignedLongLong(t);
+}
+
+static PyObject* py_overhead(PyObject *self, PyObject *args) {
+    if(overhead == (uint64_t)-1)
+        overhead = measure_overhead();
+    return PyLong_FromUnsignedLongLong(overhead);
+}
+
+static PyObject* py_elapsed(PyObject *self, PyObject *args) {
+    unsigned long long t0, t1, d;
+
+    if(!PyArg_ParseTuple(args, "KK:elapsed", &t0, &t1))
+        return NULL;
+
+    if(overhead == (uint64_t)-1)
+        overhead = measure_overhead();
+
+    d = t1 - t0;
+    d = (d > overhead) ? d - overhead : 0;
+    return PyLong_FromUnsignedLongLong(d);
+}
+
+static PyObject* py_calibrate(PyObject *self, PyObject *args) {
+    double seconds = 0.1;
+
+    if(!PyArg_ParseTuple(args, "|d:calibrate", &seconds))
+        return NULL;
+    if(seconds <= 0) {
+        PyErr_SetString(PyExc_ValueError, "calibration time must be positive");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ticks_per_ns = measure_ticks_per_ns((uint64_t)(seconds * 1e9));
+    Py_END_ALLOW_THREADS
+
+    return PyFloat_FromDouble(ticks_per_ns);
+}
+
+static PyObject* py_to_ns(PyObject *self, PyObject *args) {
+    double ticks;
+
+    if(!PyArg_ParseTuple(args, "d:to_ns", &ticks))
+        return NULL;
+
+    if(ticks_per_ns == 0) {
+        Py_BEGIN_ALLOW_THREADS
+        ticks_per_ns = measure_ticks_per_ns(100000000);
+        Py_END_ALLOW_THREADS
+    }
+
+    return PyFloat_FromDouble(ticks / ticks_per_ns);
+}
+
 static PyMethodDef methods[] = {
+#if HAVE_TSC
     {"rdtsc", py_cycles, METH_NOARGS, "Return CPU cycle counter"},
+    {"rdtscp", py_rdtscp, METH_NOARGS, "Return CPU cycle counter after all earlier instructions retired"},
+    {"rdtsc_fenced", py_rdtsc_fenced, METH_NOARGS, "Return CPU cycle counter, serialized with lfence"},
+#endif
+    {"clock_ns", py_clock_ns, METH_NOARGS, "Return CLOCK_MONOTONIC time in nanoseconds"},
+    {"start", py_start, METH_NOARGS, "Return serialized counter value at the start of a measured region"},
+    {"stop", py_stop, METH_NOARGS, "Return serialized counter value at the end of a measured region"},
+    {"overhead", py_overhead, METH_NOARGS, "Return the measured cost of an empty start()/stop() pair"},
+    {"elapsed", py_elapsed, METH_VARARGS, "elapsed(t0, t1): return t1 - t0 minus the start()/stop() overhead"},
+    {"calibrate", py_calibrate, METH_VARARGS,
+     "calibrate(seconds=0.1): measure and return counter ticks per nanosecond"},
+    {"to_ns", py_to_ns, METH_VARARGS, "to_ns(ticks): convert counter ticks to nanoseconds, calibrating if needed"},
     {NULL, NULL, 0, NULL}
 };
 
@@ -40,5 +238,12 @@ static struct PyModuleDef module = {
 };
 
 PyMODINIT_FUNC PyInit_cycles(void) {
-    return PyModule_Create(&module);
+    PyObject *m = PyModule_Create(&module);
+
+    if(m && PyModule_AddStringConstant(m, "SOURCE", COUNTER_SOURCE) < 0) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    return m;
 }
@@ -0,0 +1,388 @@
+// kybermodule.c
+//
+// CPython binding for the reference Kyber KEM. The same source is compiled
+// once per parameter set (see setup.py), with KYBER_K and KYBER_MODULE set
+// on the command line, producing the modules kyber512, kyber768 and
+// kyber1024.
+//
+// All functions accept any object supporting the buffer protocol (bytes,
+// bytearray, memoryview, numpy arrays, ...) and read or write it in place.
+// The *_batch functions operate on contiguous arrays of n keys, ciphertexts
+// or shared secrets laid out back to back. The GIL is released while the
+// actual computation runs.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <string.h>
+#include "ref/kem.h"
+
+#ifndef KYBER_MODULE
+#error "KYBER_MODULE must be defined to the module name"
+#endif
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+#define CAT_(a, b) a##b
+#define CAT(a, b) CAT_(a, b)
+
+// Acquire a C-contiguous view of obj; writable views are required for outputs
+static int get_buffer(PyObject *obj, Py_buffer *view, int writable, const char *name) {
+    int flags = PyBUF_C_CONTIGUOUS;
+
+    if(writable)
+        flags |= PyBUF_WRITABLE;
+
+    if(PyObject_GetBuffer(obj, view, flags) < 0) {
+        if(PyErr_ExceptionMatches(PyExc_BufferError) || PyErr_ExceptionMatches(PyExc_TypeError)) {
+            PyErr_Clear();
+            PyErr_Format(PyExc_TypeError, "%s must be a %scontiguous buffer", name,
+                         writable ? "writable " : "");
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+// Check that view holds exactly len bytes
+static int check_len(const Py_buffer *view, Py_ssize_t len, const char *name) {
+    if(view->len != len) {
+        PyErr_Format(PyExc_ValueError, "%s must be %zd bytes, got %zd", name, len, view->len);
+        return -1;
+    }
+    return 0;
+}
+
+// Return the number of len-sized records in view, or -1 if it is not a
+// non-empty whole multiple of len
+static Py_ssize_t count_records(const Py_buffer *view, Py_ssize_t len, const char *name) {
+    if(view->len == 0 || view->len % len) {
+        PyErr_Format(PyExc_ValueError, "%s must be a non-empty multiple of %zd bytes, got %zd",
+                     name, len, view->len);
+        return -1;
+    }
+    return view->len / len;
+}
+
+// --- single operations returning new bytes objects ---
+
+// The *_noop variants marshal arguments and results exactly like the real
+// calls but skip the KEM itself, so that FFI overhead can be measured; their
+// results are zero-filled so that no uninitialized memory reaches Python
+
+static PyObject* keypair_impl(int compute) {
+    PyObject *pk, *sk;
+
+    pk = PyBytes_FromStringAndSize(NULL, CRYPTO_PUBLICKEYBYTES);
+    sk = PyBytes_FromStringAndSize(NULL, CRYPTO_SECRETKEYBYTES);
+    if(!pk || !sk) {
+        Py_XDECREF(pk);
+        Py_XDECREF(sk);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if(compute)
+        crypto_kem_keypair((uint8_t *)PyBytes_AS_STRING(pk), (uint8_t *)PyBytes_AS_STRING(sk));
+    else {
+        memset(PyBytes_AS_STRING(pk), 0, CRYPTO_PUBLICKEYBYTES);
+        memset(PyBytes_AS_STRING(sk), 0, CRYPTO_SECRETKEYBYTES);
+    }
+    Py_END_ALLOW_THREADS
+
+    return Py_BuildValue("(NN)", pk, sk);
+}
+
+static PyObject* py_keypair(PyObject *self, PyObject *args) {
+    (void)self;
+    (void)args;
+    return keypair_impl(1);
+}
+
+static PyObject* py_keypair_noop(PyObject *self, PyObject *args) {
+    (void)self;
+    (void)args;
+    return keypair_impl(0);
+}
+
+static PyObject* enc_impl(PyObject *args, int compute) {
+    PyObject *pkobj, *ct, *ss;
+    Py_buffer pk;
+
+    if(!PyArg_ParseTuple(args, "O:enc", &pkobj))
+        return NULL;
+    if(get_buffer(pkobj, &pk, 0, "pk") < 0)
+        return NULL;
+    if(check_len(&pk, CRYPTO_PUBLICKEYBYTES, "pk") < 0) {
+        PyBuffer_Release(&pk);
+        return NULL;
+    }
+
+    ct = PyBytes_FromStringAndSize(NULL, CRYPTO_CIPHERTEXTBYTES);
+    ss = PyBytes_FromStringAndSize(NULL, CRYPTO_BYTES);
+    if(!ct || !ss) {
+        Py_XDECREF(ct);
+        Py_XDECREF(ss);
+        PyBuffer_Release(&pk);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if(compute)
+        crypto_kem_enc((uint8_t *)PyBytes_AS_STRING(ct), (uint8_t *)PyBytes_AS_STRING(ss), pk.buf);
+    else {
+        memset(PyBytes_AS_STRING(ct), 0, CRYPTO_CIPHERTEXTBYTES);
+        memset(PyBytes_AS_STRING(ss), 0, CRYPTO_BYTES);
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&pk);
+    return Py_BuildValue("(NN)", ct, ss);
+}
+
+static PyObject* py_enc(PyObject *self, PyObject *args) {
+    (void)self;
+    return enc_impl(args, 1);
+}
+
+static PyObject* py_enc_noop(PyObject *self, PyObject *args) {
+    (void)self;
+    return enc_impl(args, 0);
+}
+
+static PyObject* dec_impl(PyObject *args, int compute) {
+    PyObject *ctobj, *skobj, *ss;
+    Py_buffer ct, sk;
+
+    if(!PyArg_ParseTuple(args, "OO:dec", &ctobj, &skobj))
+        return NULL;
+    if(get_buffer(ctobj, &ct, 0, "ct") < 0)
+        return NULL;
+    if(get_buffer(skobj, &sk, 0, "sk") < 0) {
+        PyBuffer_Release(&ct);
+        return NULL;
+    }
+    if(check_len(&ct, CRYPTO_CIPHERTEXTBYTES, "ct") < 0
+       || check_len(&sk, CRYPTO_SECRETKEYBYTES, "sk") < 0
+       || !(ss = PyBytes_FromStringAndSize(NULL, CRYPTO_BYTES))) {
+        PyBuffer_Release(&ct);
+        PyBuffer_Release(&sk);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if(compute)
+        crypto_kem_dec((uint8_t *)PyBytes_AS_STRING(ss), ct.buf, sk.buf);
+    else
+        memset(PyBytes_AS_STRING(ss), 0, CRYPTO_BYTES);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&ct);
+    PyBuffer_Release(&sk);
+    return ss;
+}
+
+static PyObject* py_dec(PyObject *self, PyObject *args) {
+    (void)self;
+    return dec_impl(args, 1);
+}
+
+static PyObject* py_dec_noop(PyObject *self, PyObject *args) {
+    (void)self;
+    return dec_impl(args, 0);
+}
+
+// --- batch operations writing into caller-provided buffers ---
+
+static PyObject* py_keypair_batch(PyObject *self, PyObject *args) {
+    PyObject *pkobj, *skobj;
+    Py_buffer pk, sk;
+    Py_ssize_t i, n, nsk;
+
+    (void)self;
+
+    if(!PyArg_ParseTuple(args, "OO:keypair_batch", &pkobj, &skobj))
+        return NULL;
+    if(get_buffer(pkobj, &pk, 1, "pk") < 0)
+        return NULL;
+    if(get_buffer(skobj, &sk, 1, "sk") < 0) {
+        PyBuffer_Release(&pk);
+        return NULL;
+    }
+
+    n = count_records(&pk, CRYPTO_PUBLICKEYBYTES, "pk");
+    nsk = n < 0 ? -1 : count_records(&sk, CRYPTO_SECRETKEYBYTES, "sk");
+    if(nsk >= 0 && nsk != n) {
+        PyErr_Format(PyExc_ValueError, "pk holds %zd keys but sk holds %zd", n, nsk);
+        nsk = -1;
+    }
+    if(nsk < 0) {
+        PyBuffer_Release(&pk);
+        PyBuffer_Release(&sk);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    for(i=0;i<n;i++)
+        crypto_kem_keypair((uint8_t *)pk.buf + i*CRYPTO_PUBLICKEYBYTES,
+                           (uint8_t *)sk.buf + i*CRYPTO_SECRETKEYBYTES);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&pk);
+    PyBuffer_Release(&sk);
+    return PyLong_FromSsize_t(n);
+}
+
+// pk may hold either n public keys or a single one used for every ciphertext
+static PyObject* py_enc_batch(PyObject *self, PyObject *args) {
+    PyObject *ctobj, *ssobj, *pkobj;
+    Py_buffer ct, ss, pk;
+    Py_ssize_t i, n, nss, npk, pkstride;
+
+    (void)self;
+
+    if(!PyArg_ParseTuple(args, "OOO:enc_batch", &ctobj, &ssobj, &pkobj))
+        return NULL;
+    if(get_buffer(ctobj, &ct, 1, "ct") < 0)
+        return NULL;
+    if(get_buffer(ssobj, &ss, 1, "ss") < 0) {
+        PyBuffer_Release(&ct);
+        return NULL;
+    }
+    if(get_buffer(pkobj, &pk, 0, "pk") < 0) {
+        PyBuffer_Release(&ct);
+        PyBuffer_Release(&ss);
+        return NULL;
+    }
+
+    n = count_records(&ct, CRYPTO_CIPHERTEXTBYTES, "ct");
+    nss = n < 0 ? -1 : count_records(&ss, CRYPTO_BYTES, "ss");
+    npk = nss < 0 ? -1 : count_records(&pk, CRYPTO_PUBLICKEYBYTES, "pk");
+    if(nss >= 0 && nss != n) {
+        PyErr_Format(PyExc_ValueError, "ct holds %zd ciphertexts but ss holds %zd secrets", n, nss);
+        npk = -1;
+    }
+    else if(npk >= 0 && npk != n && npk != 1) {
+        PyErr_Format(PyExc_ValueError, "pk must hold 1 or %zd keys, got %zd", n, npk);
+        npk = -1;
+    }
+    if(npk < 0) {
+        PyBuffer_Release(&ct);
+        PyBuffer_Release(&ss);
+        PyBuffer_Release(&pk);
+        return NULL;
+    }
+    pkstride = (npk == 1) ? 0 : CRYPTO_PUBLICKEYBYTES;
+
+    Py_BEGIN_ALLOW_THREADS
+    for(i=0;i<n;i++)
+        crypto_kem_enc((uint8_t *)ct.buf + i*CRYPTO_CIPHERTEXTBYTES,
+                       (uint8_t *)ss.buf + i*CRYPTO_BYTES,
+                       (const uint8_t *)pk.buf + i*pkstride);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&ct);
+    PyBuffer_Release(&ss);
+    PyBuffer_Release(&pk);
+    return PyLong_FromSsize_t(n);
+}
+
+// sk may hold either n secret keys or a single one used for every ciphertext
+static PyObject* py_dec_batch(PyObject *self, PyObject *args) {
+    PyObject *ssobj, *ctobj, *skobj;
+    Py_buffer ss, ct, sk;
+    Py_ssize_t n, nct, nsk, skstride;
+
+    (void)self;
+
+    if(!PyArg_ParseTuple(args, "OOO:dec_batch", &ssobj, &ctobj, &skobj))
+        return NULL;
+    if(get_buffer(ssobj, &ss, 1, "ss") < 0)
+        return NULL;
+    if(get_buffer(ctobj, &ct, 0, "ct") < 0) {
+        PyBuffer_Release(&ss);
+        return NULL;
+    }
+    if(get_buffer(skobj, &sk, 0, "sk") < 0) {
+        PyBuffer_Release(&ss);
+        PyBuffer_Release(&ct);
+        return NULL;
+    }
+
+    n = count_records(&ss, CRYPTO_BYTES, "ss");
+    nct = n < 0 ? -1 : count_records(&ct, CRYPTO_CIPHERTEXTBYTES, "ct");
+    nsk = nct < 0 ? -1 : count_records(&sk, CRYPTO_SECRETKEYBYTES, "sk");
+    if(nct >= 0 && nct != n) {
+        PyErr_Format(PyExc_ValueError, "ss holds %zd secrets but ct holds %zd ciphertexts", n, nct);
+        nsk = -1;
+    }
+    else if(nsk >= 0 && nsk != n && nsk != 1) {
+        PyErr_Format(PyExc_ValueError, "sk must hold 1 or %zd keys, got %zd", n, nsk);
+        nsk = -1;
+    }
+    if(nsk < 0) {
+        PyBuffer_Release(&ss);
+        PyBuffer_Release(&ct);
+        PyBuffer_Release(&sk);
+        return NULL;
+    }
+    skstride = (nsk == 1) ? 0 : CRYPTO_SECRETKEYBYTES;
+
+    Py_BEGIN_ALLOW_THREADS
+    crypto_kem_dec_batch((uint8_t *)ss.buf, (const uint8_t *)ct.buf,
+                         (const uint8_t *)sk.buf, (size_t)skstride, (size_t)n);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&ss);
+    PyBuffer_Release(&ct);
+    PyBuffer_Release(&sk);
+    return PyLong_FromSsize_t(n);
+}
+
+static PyMethodDef methods[] = {
+    {"keypair", py_keypair, METH_NOARGS,
+     "keypair() -> (pk, sk)\n\nGenerate a fresh key pair."},
+    {"enc", py_enc, METH_VARARGS,
+     "enc(pk) -> (ct, ss)\n\nEncapsulate a fresh shared secret to pk."},
+    {"dec", py_dec, METH_VARARGS,
+     "dec(ct, sk) -> ss\n\nDecapsulate ct with sk."},
+    {"keypair_batch", py_keypair_batch, METH_VARARGS,
+     "keypair_batch(pk, sk) -> n\n\nFill the writable buffers pk and sk with n key pairs."},
+    {"enc_batch", py_enc_batch, METH_VARARGS,
+     "enc_batch(ct, ss, pk) -> n\n\nEncapsulate n times into the writable buffers ct and ss.\n"
+     "pk holds either n public keys or a single one."},
+    {"dec_batch", py_dec_batch, METH_VARARGS,
+     "dec_batch(ss, ct, sk) -> n\n\nDecapsulate n ciphertexts into the writable buffer ss.\n"
+     "sk holds either n secret keys or a single one."},
+    {"keypair_noop", py_keypair_noop, METH_NOARGS,
+     "keypair_noop() -> (pk, sk)\n\nLike keypair() but skips key generation; measures call overhead."},
+    {"enc_noop", py_enc_noop, METH_VARARGS,
+     "enc_noop(pk) -> (ct, ss)\n\nLike enc() but skips encapsulation; measures call overhead."},
+    {"dec_noop", py_dec_noop, METH_VARARGS,
+     "dec_noop(ct, sk) -> ss\n\nLike dec() but skips decapsulation; measures call overhead."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT,
+    STR(KYBER_MODULE), CRYPTO_ALGNAME " key encapsulation (reference implementation)", -1, methods
+};
+
+PyMODINIT_FUNC CAT(PyInit_, KYBER_MODULE)(void) {
+    PyObject *m = PyModule_Create(&module);
+
+    if(!m)
+        return NULL;
+
+    if(PyModule_AddStringConstant(m, "ALGNAME", CRYPTO_ALGNAME) < 0
+       || PyModule_AddIntConstant(m, "PUBLICKEYBYTES", CRYPTO_PUBLICKEYBYTES) < 0
+       || PyModule_AddIntConstant(m, "SECRETKEYBYTES", CRYPTO_SECRETKEYBYTES) < 0
+       || PyModule_AddIntConstant(m, "CIPHERTEXTBYTES", CRYPTO_CIPHERTEXTBYTES) < 0
+       || PyModule_AddIntConstant(m, "BYTES", CRYPTO_BYTES) < 0) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    return m;
+}
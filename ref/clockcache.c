@@ -0,0 +1,273 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "params.h"
+#include "clockcache.h"
+#include "verify.h"
+
+#define CLOCKCACHE_NONE UINT32_MAX
+
+typedef struct {
+  uint64_t hash;
+  uint32_t next;
+  atomic_uchar referenced;
+} clockcache_slot;
+
+/* Entries 0..nentries-1 are in use, each in the chain of its bucket; the
+ * clock hand only moves once all are in use. Entry i keeps its key and
+ * value at data + i*(keybytes + valuebytes). */
+struct clockcache {
+  clockcache_slot *slots;
+  uint8_t *data;
+  uint32_t *buckets;
+  size_t keybytes;
+  size_t valuebytes;
+  uint32_t capacity;
+  uint32_t nentries;
+  uint32_t mask;
+  uint32_t hand;
+  pthread_rwlock_t lock;
+  atomic_uint_fast64_t hits;
+  atomic_uint_fast64_t misses;
+  atomic_uint_fast64_t evictions;
+};
+
+/*************************************************
+* Name:        clockcache_mix64
+*
+* Description: splitmix64 finalizer; spreads ids or key words over
+*              hash tables
+*
+* Arguments:   - uint64_t x: input word
+*
+* Returns the mixed word
+**************************************************/
+uint64_t clockcache_mix64(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static uint8_t *entry(const clockcache *c, uint32_t i)
+{
+  return c->data + (size_t)i*(c->keybytes + c->valuebytes);
+}
+
+static uint32_t bucket(const clockcache *c, uint64_t hash)
+{
+  return (uint32_t)(hash >> 32) & c->mask;
+}
+
+static uint32_t lookup(const clockcache *c, uint64_t hash, const void *key)
+{
+  uint32_t i;
+
+  for(i=c->buckets[bucket(c, hash)];i!=CLOCKCACHE_NONE;i=c->slots[i].next)
+    if(c->slots[i].hash == hash && !memcmp(entry(c, i), key, c->keybytes))
+      return i;
+  return CLOCKCACHE_NONE;
+}
+
+/*************************************************
+* Name:        victim
+*
+* Description: Advances the clock hand to the first entry that was not
+*              hit since the hand last passed it, clearing the hits on
+*              the way, and unlinks it; must hold the lock exclusively
+**************************************************/
+static uint32_t victim(clockcache *c)
+{
+  uint32_t i, *p;
+
+  do {
+    i = c->hand;
+    c->hand = (c->hand + 1) % c->capacity;
+  } while(atomic_exchange(&c->slots[i].referenced, 0));
+
+  for(p=&c->buckets[bucket(c, c->slots[i].hash)];*p!=i;p=&c->slots[*p].next);
+  *p = c->slots[i].next;
+  return i;
+}
+
+/*************************************************
+* Name:        clockcache_new
+*
+* Description: Creates an empty cache
+*
+* Arguments:   - size_t budget: memory budget in bytes; an entry takes
+*                somewhat more than keybytes + valuebytes
+*              - size_t keybytes: size of a key
+*              - size_t valuebytes: size of a value
+*
+* Returns the cache, or NULL if the budget does not hold one entry or
+* the cache could not be created
+**************************************************/
+clockcache *clockcache_new(size_t budget, size_t keybytes, size_t valuebytes)
+{
+  uint32_t i, nbuckets;
+  size_t capacity;
+  clockcache *c;
+
+  capacity = budget / (keybytes + valuebytes + sizeof(clockcache_slot) + 2*sizeof(uint32_t));
+  if(capacity == 0)
+    return NULL;
+  if(capacity > UINT32_MAX/2)
+    capacity = UINT32_MAX/2;
+  for(nbuckets=1;nbuckets<capacity;nbuckets*=2);
+
+  c = calloc(1, sizeof(clockcache));
+  if(!c)
+    return NULL;
+  c->slots = calloc(capacity, sizeof(clockcache_slot));
+  c->data = malloc(capacity*(keybytes + valuebytes));
+  c->buckets = malloc(nbuckets*sizeof(uint32_t));
+  if(!c->slots || !c->data || !c->buckets) {
+    free(c->slots);
+    free(c->data);
+    free(c->buckets);
+    free(c);
+    return NULL;
+  }
+  for(i=0;i<nbuckets;i++)
+    c->buckets[i] = CLOCKCACHE_NONE;
+  c->keybytes = keybytes;
+  c->valuebytes = valuebytes;
+  c->capacity = capacity;
+  c->mask = nbuckets - 1;
+  pthread_rwlock_init(&c->lock, NULL);
+
+  return c;
+}
+
+/*************************************************
+* Name:        clockcache_free
+*
+* Description: Wipes and frees a cache
+*
+* Arguments:   - clockcache *c: pointer to cache (may be NULL)
+**************************************************/
+void clockcache_free(clockcache *c)
+{
+  if(!c)
+    return;
+  pthread_rwlock_destroy(&c->lock);
+  wipe(c->data, (size_t)c->nentries*(c->keybytes + c->valuebytes));
+  free(c->slots);
+  free(c->data);
+  free(c->buckets);
+  free(c);
+}
+
+/*************************************************
+* Name:        clockcache_get
+*
+* Description: Looks a key up and on a hit copies its value out, so that
+*              the shared lock is held only briefly; counts the hit or
+*              miss
+*
+* Arguments:   - clockcache *c: pointer to cache
+*              - uint64_t hash: hash of the key
+*              - const void *key: pointer to key
+*              - void *value: pointer to output value
+*
+* Returns 0 on a hit, -1 on a miss (value is then untouched)
+**************************************************/
+int clockcache_get(clockcache *c, uint64_t hash, const void *key, void *value)
+{
+  uint32_t i;
+
+  pthread_rwlock_rdlock(&c->lock);
+  i = lookup(c, hash, key);
+  if(i != CLOCKCACHE_NONE) {
+    memcpy(value, entry(c, i) + c->keybytes, c->valuebytes);
+    atomic_store(&c->slots[i].referenced, 1);
+  }
+  pthread_rwlock_unlock(&c->lock);
+
+  if(i == CLOCKCACHE_NONE) {
+    atomic_fetch_add(&c->misses, 1);
+    return -1;
+  }
+  atomic_fetch_add(&c->hits, 1);
+  return 0;
+}
+
+/*************************************************
+* Name:        clockcache_contains
+*
+* Description: Checks for a key without counting or marking it
+*
+* Arguments:   - clockcache *c: pointer to cache
+*              - uint64_t hash: hash of the key
+*              - const void *key: pointer to key
+*
+* Returns 1 if the key is cached, 0 otherwise
+**************************************************/
+int clockcache_contains(clockcache *c, uint64_t hash, const void *key)
+{
+  uint32_t i;
+
+  pthread_rwlock_rdlock(&c->lock);
+  i = lookup(c, hash, key);
+  pthread_rwlock_unlock(&c->lock);
+  return i != CLOCKCACHE_NONE;
+}
+
+/*************************************************
+* Name:        clockcache_put
+*
+* Description: Inserts a value unless another thread inserted the key
+*              meanwhile, evicting an entry if the cache is full
+*
+* Arguments:   - clockcache *c: pointer to cache
+*              - uint64_t hash: hash of the key
+*              - const void *key: pointer to key
+*              - const void *value: pointer to value
+**************************************************/
+void clockcache_put(clockcache *c, uint64_t hash, const void *key, const void *value)
+{
+  uint32_t i, b = bucket(c, hash);
+
+  pthread_rwlock_wrlock(&c->lock);
+  if(lookup(c, hash, key) == CLOCKCACHE_NONE) {
+    if(c->nentries < c->capacity)
+      i = c->nentries++;
+    else {
+      i = victim(c);
+      atomic_fetch_add(&c->evictions, 1);
+    }
+    memcpy(entry(c, i), key, c->keybytes);
+    memcpy(entry(c, i) + c->keybytes, value, c->valuebytes);
+    c->slots[i].hash = hash;
+    atomic_store(&c->slots[i].referenced, 0);
+    c->slots[i].next = c->buckets[b];
+    c->buckets[b] = i;
+  }
+  pthread_rwlock_unlock(&c->lock);
+}
+
+/*************************************************
+* Name:        clockcache_get_stats
+*
+* Description: Reads the counters and fill level of a cache
+*
+* Arguments:   - clockcache *c: pointer to cache
+*              - clockcache_stats *stats: pointer to output statistics
+**************************************************/
+void clockcache_get_stats(clockcache *c, clockcache_stats *stats)
+{
+  pthread_rwlock_rdlock(&c->lock);
+  stats->entries = c->nentries;
+  pthread_rwlock_unlock(&c->lock);
+  stats->capacity = c->capacity;
+  stats->hits = atomic_load(&c->hits);
+  stats->misses = atomic_load(&c->misses);
+  stats->evictions = atomic_load(&c->evictions);
+}
@@ -0,0 +1,49 @@
+#ifndef CLOCKCACHE_H
+#define CLOCKCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+
+/* Bounded cache of fixed-size values under fixed-size keys, shared by the
+ * caches of expanded public keys (pkcache.h) and private keys
+ * (seedkey.h). The caller hashes the key; entries are chained per bucket
+ * of the hash and confirmed on the full key. Once the memory budget is
+ * used up, inserting evicts the least recently used entry (CLOCK
+ * approximation). Lookups copy the value out under a shared lock (POSIX
+ * threads), so hits from many threads proceed in parallel; only inserts
+ * take it exclusively. Overwritten entries and, when the cache is freed,
+ * all entries are wiped. */
+
+typedef struct clockcache clockcache;
+
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  size_t entries;
+  size_t capacity;
+} clockcache_stats;
+
+#define clockcache_mix64 KYBER_NAMESPACE(clockcache_mix64)
+uint64_t clockcache_mix64(uint64_t x);
+
+#define clockcache_new KYBER_NAMESPACE(clockcache_new)
+clockcache *clockcache_new(size_t budget, size_t keybytes, size_t valuebytes);
+
+#define clockcache_free KYBER_NAMESPACE(clockcache_free)
+void clockcache_free(clockcache *c);
+
+#define clockcache_get KYBER_NAMESPACE(clockcache_get)
+int clockcache_get(clockcache *c, uint64_t hash, const void *key, void *value);
+
+#define clockcache_contains KYBER_NAMESPACE(clockcache_contains)
+int clockcache_contains(clockcache *c, uint64_t hash, const void *key);
+
+#define clockcache_put KYBER_NAMESPACE(clockcache_put)
+void clockcache_put(clockcache *c, uint64_t hash, const void *key, const void *value);
+
+#define clockcache_get_stats KYBER_NAMESPACE(clockcache_get_stats)
+void clockcache_get_stats(clockcache *c, clockcache_stats *stats);
+
+#endif
@@ -79,7 +79,7 @@ static const uint64_t KeccakF_RoundConstants[NROUNDS] = {
 *
 * Arguments:   - uint64_t *state: pointer to input/output Keccak state
 **************************************************/
-static void KeccakF1600_StatePermute(uint64_t state[25])
+void KeccakF1600_StatePermute(uint64_t state[25])
 {
         int round;
 
@@ -378,18 +378,25 @@ static unsigned int keccak_absorb(uint64_t s[25],
 {
   unsigned int i;
 
+  /* Bytewise up to the next lane boundary; r is a multiple of 8 */
+  for(;pos%8 && inlen;inlen--,pos++)
+    s[pos/8] ^= (uint64_t)*in++ << 8*(pos%8);
+
   while(pos+inlen >= r) {
-    for(i=pos;i<r;i++)
-      s[i/8] ^= (uint64_t)*in++ << 8*(i%8);
+    for(i=pos/8;i<r/8;i++,in+=8)
+      s[i] ^= load64(in);
     inlen -= r-pos;
     KeccakF1600_StatePermute(s);
     pos = 0;
   }
 
-  for(i=pos;i<pos+inlen;i++)
-    s[i/8] ^= (uint64_t)*in++ << 8*(i%8);
+  for(;inlen>=8;inlen-=8,pos+=8,in+=8)
+    s[pos/8] ^= load64(in);
+
+  for(;inlen;inlen--,pos++)
+    s[pos/8] ^= (uint64_t)*in++ << 8*(pos%8);
 
-  return i;
+  return pos;
 }
 
 /*************************************************
@@ -429,17 +436,19 @@ static unsigned int keccak_squeeze(uint8_t *out,
                                    unsigned int pos,
                                    unsigned int r)
 {
-  unsigned int i;
-
   while(outlen) {
     if(pos == r) {
       KeccakF1600_StatePermute(s);
       pos = 0;
     }
-    for(i=pos;i < r && i < pos+outlen; i++)
-      *out++ = s[i/8] >> 8*(i%8);
-    outlen -= i-pos;
-    pos = i;
+    /* Bytewise up to the next lane boundary, then full lanes, then the
+     * remaining bytes; r is a multiple of 8 */
+    for(;pos%8 && outlen;outlen--,pos++)
+      *out++ = s[pos/8] >> 8*(pos%8);
+    for(;pos < r && outlen >= 8;outlen-=8,pos+=8,out+=8)
+      store64(out, s[pos/8]);
+    for(;pos < r && outlen;outlen--,pos++)
+      *out++ = s[pos/8] >> 8*(pos%8);
   }
 
   return pos;
@@ -477,7 +486,9 @@ static void keccak_absorb_once(uint64_t s[25],
     KeccakF1600_StatePermute(s);
   }
 
-  for(i=0;i<inlen;i++)
+  for(i=0;i<inlen/8;i++)
+    s[i] ^= load64(in+8*i);
+  for(i=8*i;i<inlen;i++)
     s[i/8] ^= (uint64_t)in[i] << 8*(i%8);
 
   s[i/8] ^= (uint64_t)p << 8*(i%8);
@@ -753,6 +764,52 @@ void sha3_256(uint8_t h[32], const uint8_t *in, size_t inlen)
     store64(h+8*i,s[i]);
 }
 
+/*************************************************
+* Name:        sha3_256_init
+*
+* Description: Initializes Keccak state for use as SHA3-256 with
+*              incremental API
+*
+* Arguments:   - keccak_state *state: pointer to (uninitialized) Keccak state
+**************************************************/
+void sha3_256_init(keccak_state *state)
+{
+  keccak_init(state->s);
+  state->pos = 0;
+}
+
+/*************************************************
+* Name:        sha3_256_absorb
+*
+* Description: Absorb step of SHA3-256; incremental.
+*
+* Arguments:   - keccak_state *state: pointer to (initialized) Keccak state
+*              - const uint8_t *in: pointer to input to be absorbed into s
+*              - size_t inlen: length of input in bytes
+**************************************************/
+void sha3_256_absorb(keccak_state *state, const uint8_t *in, size_t inlen)
+{
+  state->pos = keccak_absorb(state->s, state->pos, SHA3_256_RATE, in, inlen);
+}
+
+/*************************************************
+* Name:        sha3_256_finalize
+*
+* Description: Finalizes SHA3-256 and outputs the hash of all absorbed input
+*
+* Arguments:   - uint8_t *h: pointer to output (32 bytes)
+*              - keccak_state *state: pointer to Keccak state
+**************************************************/
+void sha3_256_finalize(uint8_t h[32], keccak_state *state)
+{
+  unsigned int i;
+
+  keccak_finalize(state->s, state->pos, SHA3_256_RATE, 0x06);
+  KeccakF1600_StatePermute(state->s);
+  for(i=0;i<4;i++)
+    store64(h+8*i,state->s[i]);
+}
+
 /*************************************************
 * Name:        sha3_512
 *
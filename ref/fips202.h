@@ -16,6 +16,9 @@ typedef struct {
   unsigned int pos;
 } keccak_state;
 
+#define KeccakF1600_StatePermute FIPS202_NAMESPACE(KeccakF1600_StatePermute)
+void KeccakF1600_StatePermute(uint64_t state[25]);
+
 #define shake128_init FIPS202_NAMESPACE(shake128_init)
 void shake128_init(keccak_state *state);
 #define shake128_absorb FIPS202_NAMESPACE(shake128_absorb)
@@ -48,6 +51,12 @@ void shake128(uint8_t *out, size_t outlen, const uint8_t *in, size_t inlen);
 void shake256(uint8_t *out, size_t outlen, const uint8_t *in, size_t inlen);
 #define sha3_256 FIPS202_NAMESPACE(sha3_256)
 void sha3_256(uint8_t h[32], const uint8_t *in, size_t inlen);
+#define sha3_256_init FIPS202_NAMESPACE(sha3_256_init)
+void sha3_256_init(keccak_state *state);
+#define sha3_256_absorb FIPS202_NAMESPACE(sha3_256_absorb)
+void sha3_256_absorb(keccak_state *state, const uint8_t *in, size_t inlen);
+#define sha3_256_finalize FIPS202_NAMESPACE(sha3_256_finalize)
+void sha3_256_finalize(uint8_t h[32], keccak_state *state);
 #define sha3_512 FIPS202_NAMESPACE(sha3_512)
 void sha3_512(uint8_t h[64], const uint8_t *in, size_t inlen);
 
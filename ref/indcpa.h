@@ -24,4 +24,45 @@ void indcpa_dec(uint8_t m[KYBER_INDCPA_MSGBYTES],
                 const uint8_t c[KYBER_INDCPA_BYTES],
                 const uint8_t sk[KYBER_INDCPA_SECRETKEYBYTES]);
 
+/* Key pair with both polyvecs unpacked and the transposed matrix A^T
+ * expanded, in the poly layout of this implementation */
+typedef struct {
+  polyvec at[KYBER_K];
+  polyvec pkpv;
+  polyvec skpv;
+} indcpa_expanded_sk;
+
+#define indcpa_sk_expand KYBER_NAMESPACE(indcpa_sk_expand)
+void indcpa_sk_expand(indcpa_expanded_sk *esk,
+                      const uint8_t sk[KYBER_INDCPA_SECRETKEYBYTES],
+                      const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES]);
+
+#define indcpa_enc_expanded KYBER_NAMESPACE(indcpa_enc_expanded)
+void indcpa_enc_expanded(uint8_t c[KYBER_INDCPA_BYTES],
+                         const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                         const indcpa_expanded_sk *esk,
+                         const uint8_t coins[KYBER_SYMBYTES]);
+
+#define indcpa_dec_expanded KYBER_NAMESPACE(indcpa_dec_expanded)
+void indcpa_dec_expanded(uint8_t m[KYBER_INDCPA_MSGBYTES],
+                         const uint8_t c[KYBER_INDCPA_BYTES],
+                         const indcpa_expanded_sk *esk);
+
+/* Public key with the polyvec unpacked and A^T expanded, in the poly
+ * layout of this implementation */
+typedef struct {
+  polyvec at[KYBER_K];
+  polyvec pkpv;
+} indcpa_expanded_pk;
+
+#define indcpa_pk_expand KYBER_NAMESPACE(indcpa_pk_expand)
+void indcpa_pk_expand(indcpa_expanded_pk *epk,
+                      const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES]);
+
+#define indcpa_enc_expanded_pk KYBER_NAMESPACE(indcpa_enc_expanded_pk)
+void indcpa_enc_expanded_pk(uint8_t c[KYBER_INDCPA_BYTES],
+                            const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                            const indcpa_expanded_pk *epk,
+                            const uint8_t coins[KYBER_SYMBYTES]);
+
 #endif
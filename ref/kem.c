@@ -57,10 +57,10 @@ int crypto_kem_keypair(uint8_t *pk,
 }
 
 /*************************************************
-* Name:        crypto_kem_enc_derand
+* Name:        enc_hpk_derand
 *
-* Description: Generates cipher text and shared
-*              secret for given public key
+* Description: Generates cipher text and shared secret for given
+*              public key and its hash H(pk)
 *
 * Arguments:   - uint8_t *ct: pointer to output cipher text
 *                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
@@ -68,15 +68,16 @@ int crypto_kem_keypair(uint8_t *pk,
 *                (an already allocated array of KYBER_SSBYTES bytes)
 *              - const uint8_t *pk: pointer to input public key
 *                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - const uint8_t *hpk: pointer to input hash of pk
+*                (an already allocated array of KYBER_SYMBYTES bytes)
 *              - const uint8_t *coins: pointer to input randomness
 *                (an already allocated array filled with KYBER_SYMBYTES random bytes)
-**
-* Returns 0 (success)
 **************************************************/
-int crypto_kem_enc_derand(uint8_t *ct,
-                          uint8_t *ss,
-                          const uint8_t *pk,
-                          const uint8_t *coins)
+static void enc_hpk_derand(uint8_t *ct,
+                           uint8_t *ss,
+                           const uint8_t *pk,
+                           const uint8_t *hpk,
+                           const uint8_t *coins)
 {
   uint8_t buf[2*KYBER_SYMBYTES];
   /* Will contain key, coins */
@@ -85,13 +86,41 @@ int crypto_kem_enc_derand(uint8_t *ct,
   memcpy(buf, coins, KYBER_SYMBYTES);
 
   /* Multitarget countermeasure for coins + contributory KEM */
-  hash_h(buf+KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
+  memcpy(buf+KYBER_SYMBYTES, hpk, KYBER_SYMBYTES);
   hash_g(kr, buf, 2*KYBER_SYMBYTES);
 
   /* coins are in kr+KYBER_SYMBYTES */
   indcpa_enc(ct, buf, pk, kr+KYBER_SYMBYTES);
 
   memcpy(ss,kr,KYBER_SYMBYTES);
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_derand
+*
+* Description: Generates cipher text and shared
+*              secret for given public key
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+**
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_derand(uint8_t *ct,
+                          uint8_t *ss,
+                          const uint8_t *pk,
+                          const uint8_t *coins)
+{
+  uint8_t hpk[KYBER_SYMBYTES];
+
+  hash_h(hpk, pk, KYBER_PUBLICKEYBYTES);
+  enc_hpk_derand(ct, ss, pk, hpk, coins);
   return 0;
 }
 
@@ -120,6 +149,110 @@ int crypto_kem_enc(uint8_t *ct,
   return 0;
 }
 
+/*************************************************
+* Name:        crypto_kem_pkctx_init
+*
+* Description: Prepares a public key for repeated encapsulation:
+*              copies pk and caches H(pk)
+*
+* Arguments:   - kem_pkctx *ctx: pointer to output public-key context
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_pkctx_init(kem_pkctx *ctx, const uint8_t *pk)
+{
+  memcpy(ctx->pk, pk, KYBER_PUBLICKEYBYTES);
+  hash_h(ctx->hpk, pk, KYBER_PUBLICKEYBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_pkctx_derand
+*
+* Description: Generates cipher text and shared secret for the public
+*              key in ctx without rehashing it; same output as
+*              crypto_kem_enc_derand on ctx->pk
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const kem_pkctx *ctx: pointer to input public-key context
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_pkctx_derand(uint8_t *ct,
+                                uint8_t *ss,
+                                const kem_pkctx *ctx,
+                                const uint8_t *coins)
+{
+  enc_hpk_derand(ct, ss, ctx->pk, ctx->hpk, coins);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_pkctx
+*
+* Description: Generates cipher text and shared secret for the public
+*              key in ctx without rehashing it
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const kem_pkctx *ctx: pointer to input public-key context
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_pkctx(uint8_t *ct,
+                         uint8_t *ss,
+                         const kem_pkctx *ctx)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_pkctx_derand(ct, ss, ctx, coins);
+  return 0;
+}
+
+/*************************************************
+* Name:        dec_reencrypt
+*
+* Description: Decrypts the cipher text, derives key and coins and checks
+*              that re-encryption reproduces the cipher text
+*
+* Arguments:   - uint8_t *kr: pointer to output key and coins
+*                (an already allocated array of 2*KYBER_SYMBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*
+* Returns 0 if the cipher text is valid and 1 otherwise
+**************************************************/
+static int dec_reencrypt(uint8_t kr[2*KYBER_SYMBYTES],
+                         const uint8_t *ct,
+                         const uint8_t *sk)
+{
+  uint8_t buf[2*KYBER_SYMBYTES];
+  uint8_t cmp[KYBER_CIPHERTEXTBYTES];
+  const uint8_t *pk = sk+KYBER_INDCPA_SECRETKEYBYTES;
+
+  indcpa_dec(buf, ct, sk);
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  memcpy(buf+KYBER_SYMBYTES, sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  indcpa_enc(cmp, buf, pk, kr+KYBER_SYMBYTES);
+
+  return verify(ct, cmp, KYBER_CIPHERTEXTBYTES);
+}
+
 /*************************************************
 * Name:        crypto_kem_dec
 *
@@ -140,31 +273,350 @@ int crypto_kem_enc(uint8_t *ct,
 int crypto_kem_dec(uint8_t *ss,
                    const uint8_t *ct,
                    const uint8_t *sk)
+{
+  int fail;
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+
+  fail = dec_reencrypt(kr, ct, sk);
+
+  /* Compute rejection key */
+  rkprf(ss,sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES,ct);
+
+  /* Copy true key to return buffer if fail is false */
+  cmov(ss,kr,KYBER_SYMBYTES,!fail);
+
+  return 0;
+}
+
+/*************************************************
+* Name:        hash_g_lanes
+*
+* Description: hash_g of up to KYBER_DEC_BATCH independent inputs of
+*              2*KYBER_SYMBYTES bytes; uses the 4-way hash where available,
+*              filling unused lanes with copies of lane 0
+**************************************************/
+static void hash_g_lanes(uint8_t kr[][2*KYBER_SYMBYTES],
+                         const uint8_t buf[][2*KYBER_SYMBYTES],
+                         unsigned int n)
+{
+  unsigned int j;
+
+#ifdef hash_g_x4
+  if(n > 1) {
+    hash_g_x4(kr[0], kr[1], kr[n > 2 ? 2 : 0], kr[n > 3 ? 3 : 0],
+              buf[0], buf[1], buf[n > 2 ? 2 : 0], buf[n > 3 ? 3 : 0],
+              2*KYBER_SYMBYTES);
+    return;
+  }
+#endif
+  for(j=0;j<n;j++)
+    hash_g(kr[j], buf[j], 2*KYBER_SYMBYTES);
+}
+
+/*************************************************
+* Name:        rkprf_lanes
+*
+* Description: Rejection keys of up to KYBER_DEC_BATCH decapsulations,
+*              written to consecutive shared secrets; 4-way where available
+**************************************************/
+static void rkprf_lanes(uint8_t *ss,
+                        const uint8_t *sk[],
+                        const uint8_t *ct[],
+                        unsigned int n)
+{
+  unsigned int j;
+
+#ifdef rkprf_x4
+  if(n > 1) {
+    rkprf_x4(ss, ss+KYBER_SSBYTES, ss+(n > 2 ? 2 : 0)*KYBER_SSBYTES, ss+(n > 3 ? 3 : 0)*KYBER_SSBYTES,
+             sk[0]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES,
+             sk[1]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES,
+             sk[n > 2 ? 2 : 0]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES,
+             sk[n > 3 ? 3 : 0]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES,
+             ct[0], ct[1], ct[n > 2 ? 2 : 0], ct[n > 3 ? 3 : 0]);
+    return;
+  }
+#endif
+  for(j=0;j<n;j++)
+    rkprf(ss+j*KYBER_SSBYTES, sk[j]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES, ct[j]);
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_batch
+*
+* Description: Generates shared secrets for n cipher texts; same output as
+*              n calls of crypto_kem_dec. The cipher texts are processed
+*              in groups of KYBER_DEC_BATCH, one stage at a time: all
+*              decryptions, hash_g of the group, all re-encryptions, the
+*              rejection keys of the group. The independent work of a group
+*              overlaps in the pipeline, and the hash stages use multi-lane
+*              Keccak where the implementation provides it.
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secrets
+*                (an already allocated array of n*KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher texts
+*                (an array of n*KYBER_CIPHERTEXTBYTES bytes)
+*              - const uint8_t *sk: pointer to input private keys
+*                (KYBER_SECRETKEYBYTES bytes each)
+*              - size_t skstride: distance between consecutive private keys
+*                in bytes; KYBER_SECRETKEYBYTES for n keys, 0 for one key
+*              - size_t n: number of cipher texts
+*
+* Returns 0.
+*
+* On failure, the respective ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_batch(uint8_t *ss,
+                         const uint8_t *ct,
+                         const uint8_t *sk,
+                         size_t skstride,
+                         size_t n)
+{
+  unsigned int j, m;
+  int fail[KYBER_DEC_BATCH];
+  uint8_t buf[KYBER_DEC_BATCH][2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[KYBER_DEC_BATCH][2*KYBER_SYMBYTES];
+  uint8_t cmp[KYBER_CIPHERTEXTBYTES];
+  const uint8_t *c[KYBER_DEC_BATCH];
+  const uint8_t *s[KYBER_DEC_BATCH];
+
+  while(n > 0) {
+    m = (n < KYBER_DEC_BATCH) ? n : KYBER_DEC_BATCH;
+    for(j=0;j<m;j++) {
+      c[j] = ct + j*KYBER_CIPHERTEXTBYTES;
+      s[j] = sk + j*skstride;
+    }
+
+    for(j=0;j<m;j++) {
+      indcpa_dec(buf[j], c[j], s[j]);
+      /* Multitarget countermeasure for coins + contributory KEM */
+      memcpy(buf[j]+KYBER_SYMBYTES, s[j]+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+    }
+
+    hash_g_lanes(kr, (const uint8_t (*)[2*KYBER_SYMBYTES])buf, m);
+
+    for(j=0;j<m;j++) {
+      /* coins are in kr+KYBER_SYMBYTES */
+      indcpa_enc(cmp, buf[j], s[j]+KYBER_INDCPA_SECRETKEYBYTES, kr[j]+KYBER_SYMBYTES);
+      fail[j] = verify(c[j], cmp, KYBER_CIPHERTEXTBYTES);
+    }
+
+    /* Compute rejection keys */
+    rkprf_lanes(ss, s, c, m);
+
+    /* Copy true keys to return buffer if fail is false */
+    for(j=0;j<m;j++)
+      cmov(ss+j*KYBER_SSBYTES, kr[j], KYBER_SYMBYTES, !fail[j]);
+
+    ss += m*KYBER_SSBYTES;
+    ct += m*KYBER_CIPHERTEXTBYTES;
+    sk += m*skstride;
+    n -= m;
+  }
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_skctx_init
+*
+* Description: Prepares a private key for repeated decapsulation:
+*              copies sk and absorbs z into the rejection PRF state
+*
+* Arguments:   - kem_skctx *ctx: pointer to output private-key context
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_skctx_init(kem_skctx *ctx, const uint8_t *sk)
+{
+  memcpy(ctx->sk, sk, KYBER_SECRETKEYBYTES);
+  rkprf_init(&ctx->rkprf, sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_skctx
+*
+* Description: Generates shared secret for given cipher text and the
+*              private key in ctx; same output as crypto_kem_dec on ctx->sk
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - const kem_skctx *ctx: pointer to input private-key context
+*
+* Returns 0.
+*
+* On failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_skctx(uint8_t *ss,
+                         const uint8_t *ct,
+                         const kem_skctx *ctx)
+{
+  int fail;
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+
+  fail = dec_reencrypt(kr, ct, ctx->sk);
+
+  /* Compute rejection key from the keyed state */
+  rkprf_final(ss,&ctx->rkprf,ct);
+
+  /* Copy true key to return buffer if fail is false */
+  cmov(ss,kr,KYBER_SYMBYTES,!fail);
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_sk_expand
+*
+* Description: Converts a private key into the expanded form used by
+*              crypto_kem_dec_expanded
+*
+* Arguments:   - kem_expanded_sk *esk: pointer to output expanded key
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_sk_expand(kem_expanded_sk *esk, const uint8_t *sk)
+{
+  indcpa_sk_expand(&esk->indcpa, sk, sk+KYBER_INDCPA_SECRETKEYBYTES);
+  rkprf_init(&esk->rkprf, sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES);
+  memcpy(esk->hpk, sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_expanded
+*
+* Description: Generates shared secret for given cipher text and expanded
+*              private key; same output as crypto_kem_dec on the key it
+*              was expanded from
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - const kem_expanded_sk *esk: pointer to input expanded key
+*
+* Returns 0.
+*
+* On failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_expanded(uint8_t *ss,
+                            const uint8_t *ct,
+                            const kem_expanded_sk *esk)
 {
   int fail;
   uint8_t buf[2*KYBER_SYMBYTES];
   /* Will contain key, coins */
   uint8_t kr[2*KYBER_SYMBYTES];
-//  uint8_t cmp[KYBER_CIPHERTEXTBYTES+KYBER_SYMBYTES];
   uint8_t cmp[KYBER_CIPHERTEXTBYTES];
-  const uint8_t *pk = sk+KYBER_INDCPA_SECRETKEYBYTES;
 
-  indcpa_dec(buf, ct, sk);
+  indcpa_dec_expanded(buf, ct, &esk->indcpa);
 
   /* Multitarget countermeasure for coins + contributory KEM */
-  memcpy(buf+KYBER_SYMBYTES, sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+  memcpy(buf+KYBER_SYMBYTES, esk->hpk, KYBER_SYMBYTES);
   hash_g(kr, buf, 2*KYBER_SYMBYTES);
 
   /* coins are in kr+KYBER_SYMBYTES */
-  indcpa_enc(cmp, buf, pk, kr+KYBER_SYMBYTES);
-
+  indcpa_enc_expanded(cmp, buf, &esk->indcpa, kr+KYBER_SYMBYTES);
   fail = verify(ct, cmp, KYBER_CIPHERTEXTBYTES);
 
-  /* Compute rejection key */
-  rkprf(ss,sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES,ct);
+  /* Compute rejection key from the keyed state */
+  rkprf_final(ss,&esk->rkprf,ct);
 
   /* Copy true key to return buffer if fail is false */
   cmov(ss,kr,KYBER_SYMBYTES,!fail);
 
   return 0;
 }
+
+/*************************************************
+* Name:        crypto_kem_pk_expand
+*
+* Description: Converts a public key into the expanded form used by
+*              crypto_kem_enc_expanded
+*
+* Arguments:   - kem_expanded_pk *epk: pointer to output expanded key
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_pk_expand(kem_expanded_pk *epk, const uint8_t *pk)
+{
+  indcpa_pk_expand(&epk->indcpa, pk);
+  hash_h(epk->hpk, pk, KYBER_PUBLICKEYBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_expanded_derand
+*
+* Description: Generates cipher text and shared secret for an expanded
+*              public key; same output as crypto_kem_enc_derand on the
+*              key it was expanded from
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const kem_expanded_pk *epk: pointer to input expanded key
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_expanded_derand(uint8_t *ct,
+                                   uint8_t *ss,
+                                   const kem_expanded_pk *epk,
+                                   const uint8_t *coins)
+{
+  uint8_t buf[2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+
+  memcpy(buf, coins, KYBER_SYMBYTES);
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  memcpy(buf+KYBER_SYMBYTES, epk->hpk, KYBER_SYMBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  indcpa_enc_expanded_pk(ct, buf, &epk->indcpa, kr+KYBER_SYMBYTES);
+
+  memcpy(ss,kr,KYBER_SYMBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_expanded
+*
+* Description: Generates cipher text and shared secret for an expanded
+*              public key
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const kem_expanded_pk *epk: pointer to input expanded key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_expanded(uint8_t *ct,
+                            uint8_t *ss,
+                            const kem_expanded_pk *epk)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_expanded_derand(ct, ss, epk, coins);
+  return 0;
+}
@@ -1,8 +1,11 @@
 #ifndef KEM_H
 #define KEM_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "params.h"
+#include "fips202.h"
+#include "indcpa.h"
 
 #define CRYPTO_SECRETKEYBYTES  KYBER_SECRETKEYBYTES
 #define CRYPTO_PUBLICKEYBYTES  KYBER_PUBLICKEYBYTES
@@ -29,7 +32,78 @@ int crypto_kem_enc_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uin
 #define crypto_kem_enc KYBER_NAMESPACE(enc)
 int crypto_kem_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
 
+/* Public key of a peer with its cached hash H(pk), for repeated
+ * encapsulation to the same key */
+typedef struct {
+  uint8_t pk[KYBER_PUBLICKEYBYTES];
+  uint8_t hpk[KYBER_SYMBYTES];
+} kem_pkctx;
+
+#define crypto_kem_pkctx_init KYBER_NAMESPACE(pkctx_init)
+int crypto_kem_pkctx_init(kem_pkctx *ctx, const uint8_t *pk);
+
+#define crypto_kem_enc_pkctx_derand KYBER_NAMESPACE(enc_pkctx_derand)
+int crypto_kem_enc_pkctx_derand(uint8_t *ct, uint8_t *ss, const kem_pkctx *ctx, const uint8_t *coins);
+
+#define crypto_kem_enc_pkctx KYBER_NAMESPACE(enc_pkctx)
+int crypto_kem_enc_pkctx(uint8_t *ct, uint8_t *ss, const kem_pkctx *ctx);
+
 #define crypto_kem_dec KYBER_NAMESPACE(dec)
 int crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
 
+#define crypto_kem_dec_batch KYBER_NAMESPACE(dec_batch)
+int crypto_kem_dec_batch(uint8_t *ss, const uint8_t *ct, const uint8_t *sk, size_t skstride, size_t n);
+
+/* Secret key with the rejection PRF state keyed by z, for repeated
+ * decapsulation with the same key */
+typedef struct {
+  uint8_t sk[KYBER_SECRETKEYBYTES];
+  keccak_state rkprf;
+} kem_skctx;
+
+#define crypto_kem_skctx_init KYBER_NAMESPACE(skctx_init)
+int crypto_kem_skctx_init(kem_skctx *ctx, const uint8_t *sk);
+
+#define crypto_kem_dec_skctx KYBER_NAMESPACE(dec_skctx)
+int crypto_kem_dec_skctx(uint8_t *ss, const uint8_t *ct, const kem_skctx *ctx);
+
+/* Private key in expanded form: both polyvecs unpacked, A^T sampled, H(pk)
+ * and the keyed rejection PRF state precomputed, so that decapsulation
+ * does no unpacking, sampling or key hashing. KYBER_EXPANDEDSECRETKEYBYTES
+ * is about 2.7x (Kyber512: 4336 bytes) to 4x (Kyber1024: 12528 bytes) the
+ * size of a packed key, slightly more in avx2. The struct is flat and
+ * contains no pointers, so it can be written to a file and mapped back, but its
+ * layout is that of the building implementation (ref and avx2 differ in
+ * coefficient order and alignment); only use it with the same build. */
+typedef struct {
+  indcpa_expanded_sk indcpa;
+  keccak_state rkprf;
+  uint8_t hpk[KYBER_SYMBYTES];
+} kem_expanded_sk;
+
+#define KYBER_EXPANDEDSECRETKEYBYTES sizeof(kem_expanded_sk)
+
+#define crypto_kem_sk_expand KYBER_NAMESPACE(sk_expand)
+int crypto_kem_sk_expand(kem_expanded_sk *esk, const uint8_t *sk);
+
+#define crypto_kem_dec_expanded KYBER_NAMESPACE(dec_expanded)
+int crypto_kem_dec_expanded(uint8_t *ss, const uint8_t *ct, const kem_expanded_sk *esk);
+
+/* Public key in expanded form: polyvec unpacked, A^T sampled and H(pk)
+ * precomputed, so that encapsulation does no unpacking, matrix sampling
+ * or key hashing. Same layout caveats as kem_expanded_sk. */
+typedef struct {
+  indcpa_expanded_pk indcpa;
+  uint8_t hpk[KYBER_SYMBYTES];
+} kem_expanded_pk;
+
+#define crypto_kem_pk_expand KYBER_NAMESPACE(pk_expand)
+int crypto_kem_pk_expand(kem_expanded_pk *epk, const uint8_t *pk);
+
+#define crypto_kem_enc_expanded_derand KYBER_NAMESPACE(enc_expanded_derand)
+int crypto_kem_enc_expanded_derand(uint8_t *ct, uint8_t *ss, const kem_expanded_pk *epk, const uint8_t *coins);
+
+#define crypto_kem_enc_expanded KYBER_NAMESPACE(enc_expanded)
+int crypto_kem_enc_expanded(uint8_t *ct, uint8_t *ss, const kem_expanded_pk *epk);
+
 #endif
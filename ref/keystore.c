@@ -0,0 +1,449 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "params.h"
+#include "kem.h"
+#include "clockcache.h"
+#include "keystore.h"
+#include "verify.h"
+
+/* File layout, all integers in host byte order:
+ *
+ *   offset 0             header (struct ks_header), padded to a page
+ *   index_offset         nslots uint32_t slots, 0 = empty, else record + 1
+ *   records_offset       nrecords records of RECORDBYTES each
+ *
+ * A record is the 64-bit key id followed by the private key and is padded
+ * to whole cache lines. In a seed store (flag KS_SEEDS) it is the key id
+ * followed by the KYBER_SEEDKEYBYTES key seed, unpadded. Index and records start on page boundaries (of the
+ * page size of the host that wrote the file), so madvise and mlock of a
+ * record touch no more pages than necessary. The index has at least twice
+ * as many slots as records and is probed linearly. */
+
+#define MAGIC "KYBERKS1"
+#define RECORDBYTES ((8 + KYBER_SECRETKEYBYTES + 63) / 64 * 64)
+#define SEEDRECORDBYTES (8 + KYBER_SEEDKEYBYTES)
+#define KS_SEEDS 1
+
+/* Records share pages and mlock does not stack, so a page must stay locked
+ * while any locked key touches it. keystore_hot and keystore_cold keep a
+ * flag per record and a count of locked keys per page of the mapping;
+ * both arrays are allocated on the first lock. */
+struct keystore_locks {
+  pthread_mutex_t mutex;
+  uint8_t *locked;
+  uint32_t *counts;
+};
+
+typedef struct {
+  char magic[8];
+  char alg[16];
+  uint64_t nrecords;
+  uint64_t recordbytes;
+  uint64_t nslots;
+  uint64_t index_offset;
+  uint64_t records_offset;
+  uint64_t flags;
+} ks_header;
+
+static uint64_t record_id(const uint8_t *record)
+{
+  uint64_t id;
+  memcpy(&id, record, 8);
+  return id;
+}
+
+static uint64_t align_up(uint64_t x, uint64_t a)
+{
+  return (x + a - 1) / a * a;
+}
+
+static int write_zeros(FILE *f, uint64_t n)
+{
+  static const uint8_t zeros[4096];
+  size_t len;
+
+  while(n > 0) {
+    len = (n < sizeof(zeros)) ? (size_t)n : sizeof(zeros);
+    if(fwrite(zeros, 1, len, f) != len)
+      return -1;
+    n -= len;
+  }
+  return 0;
+}
+
+/* Writes a store of n keys of keybytes bytes each */
+static int create(const char *path, const uint64_t *ids, const uint8_t *keys, size_t keybytes,
+                  uint64_t flags, size_t n)
+{
+  size_t i;
+  int fd, ret = -1;
+  uint64_t j, page = (uint64_t)sysconf(_SC_PAGESIZE);
+  uint32_t *index;
+  uint8_t record[RECORDBYTES] = {0};
+  size_t recordbytes = (flags & KS_SEEDS) ? SEEDRECORDBYTES : RECORDBYTES;
+  ks_header h;
+  FILE *f;
+
+  if(n >= UINT32_MAX/2)
+    return -1;
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, MAGIC, sizeof(h.magic));
+  snprintf(h.alg, sizeof(h.alg), "%s", CRYPTO_ALGNAME);
+  h.nrecords = n;
+  h.recordbytes = recordbytes;
+  h.flags = flags;
+  for(h.nslots = 16; h.nslots < 2*(uint64_t)n; h.nslots <<= 1);
+  h.index_offset = align_up(sizeof(h), page);
+  h.records_offset = h.index_offset + align_up(h.nslots*sizeof(uint32_t), page);
+
+  index = calloc(h.nslots, sizeof(uint32_t));
+  if(!index)
+    return -1;
+  for(i = 0; i < n; i++) {
+    for(j = clockcache_mix64(ids[i]) & (h.nslots - 1); index[j]; j = (j + 1) & (h.nslots - 1))
+      if(ids[index[j] - 1] == ids[i])
+        goto out;
+    index[j] = (uint32_t)(i + 1);
+  }
+
+  fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0600);
+  if(fd < 0)
+    goto out;
+  f = fdopen(fd, "wb");
+  if(!f) {
+    close(fd);
+    goto out;
+  }
+
+  ret = (fwrite(&h, sizeof(h), 1, f) == 1
+         && !write_zeros(f, h.index_offset - sizeof(h))
+         && fwrite(index, sizeof(uint32_t), h.nslots, f) == h.nslots
+         && !write_zeros(f, h.records_offset - h.index_offset - h.nslots*sizeof(uint32_t))) ? 0 : -1;
+  for(i = 0; i < n && ret == 0; i++) {
+    memcpy(record, &ids[i], 8);
+    memcpy(record + 8, keys + i*keybytes, keybytes);
+    if(fwrite(record, recordbytes, 1, f) != 1)
+      ret = -1;
+  }
+  wipe(record, sizeof(record));
+
+  if(fclose(f))
+    ret = -1;
+  if(ret)
+    unlink(path);
+
+out:
+  free(index);
+  return ret;
+}
+
+/*************************************************
+* Name:        keystore_create
+*
+* Description: Writes a key store file holding n private keys. The file is
+*              created with mode 0600 and replaced if it exists.
+*
+* Arguments:   - const char *path: output file
+*              - const uint64_t *ids: key ids (pairwise distinct)
+*              - const uint8_t *sks: n private keys of KYBER_SECRETKEYBYTES
+*                bytes each, in the order of ids
+*              - size_t n: number of keys
+*
+* Returns 0 on success, -1 on error (including duplicate ids)
+**************************************************/
+int keystore_create(const char *path, const uint64_t *ids, const uint8_t *sks, size_t n)
+{
+  return create(path, ids, sks, KYBER_SECRETKEYBYTES, 0, n);
+}
+
+/*************************************************
+* Name:        keystore_create_seeds
+*
+* Description: Writes a seed store file holding n key seeds, from which
+*              the private keys are regenerated on use (see seedkey.h).
+*              The file is created with mode 0600 and replaced if it
+*              exists.
+*
+* Arguments:   - const char *path: output file
+*              - const uint64_t *ids: key ids (pairwise distinct)
+*              - const uint8_t *seeds: n key seeds of KYBER_SEEDKEYBYTES
+*                bytes each, in the order of ids
+*              - size_t n: number of keys
+*
+* Returns 0 on success, -1 on error (including duplicate ids)
+**************************************************/
+int keystore_create_seeds(const char *path, const uint64_t *ids, const uint8_t *seeds, size_t n)
+{
+  return create(path, ids, seeds, KYBER_SEEDKEYBYTES, KS_SEEDS, n);
+}
+
+/*************************************************
+* Name:        keystore_open
+*
+* Description: Maps a key store file read-only and checks its header. The
+*              mapping is advised for random access and excluded from core
+*              dumps where supported.
+*
+* Arguments:   - keystore *ks: pointer to output key store
+*              - const char *path: file written by keystore_create
+*
+* Returns 0 on success, -1 on error or if the file is not a key store for
+* this parameter set
+**************************************************/
+int keystore_open(keystore *ks, const char *path)
+{
+  int fd;
+  struct stat st;
+  ks_header h;
+  char alg[sizeof(h.alg)];
+  uint64_t len, recordbytes;
+
+  memset(ks, 0, sizeof(*ks));
+  fd = open(path, O_RDONLY);
+  if(fd < 0)
+    return -1;
+  if(fstat(fd, &st) || (uint64_t)st.st_size < sizeof(h)) {
+    close(fd);
+    return -1;
+  }
+  len = (uint64_t)st.st_size;
+
+  ks->base = mmap(NULL, (size_t)len, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(ks->base == MAP_FAILED) {
+    ks->base = NULL;
+    return -1;
+  }
+  ks->len = (size_t)len;
+
+  memcpy(&h, ks->base, sizeof(h));
+  recordbytes = (h.flags & KS_SEEDS) ? SEEDRECORDBYTES : RECORDBYTES;
+  memset(alg, 0, sizeof(alg));
+  snprintf(alg, sizeof(alg), "%s", CRYPTO_ALGNAME);
+  if(memcmp(h.magic, MAGIC, sizeof(h.magic))
+     || memcmp(h.alg, alg, sizeof(alg))
+     || (h.flags & ~(uint64_t)KS_SEEDS) || h.recordbytes != recordbytes
+     || h.nslots == 0 || (h.nslots & (h.nslots - 1)) || h.nslots < h.nrecords
+     || h.index_offset < sizeof(h) || h.index_offset % sizeof(uint32_t)
+     || h.index_offset > len || h.nslots > (len - h.index_offset)/sizeof(uint32_t)
+     || h.records_offset < h.index_offset + h.nslots*sizeof(uint32_t)
+     || h.records_offset > len || h.nrecords > (len - h.records_offset)/recordbytes) {
+    keystore_close(ks);
+    return -1;
+  }
+
+  ks->index = (const uint32_t *)(ks->base + h.index_offset);
+  ks->mask = h.nslots - 1;
+  ks->records = ks->base + h.records_offset;
+  ks->nrecords = h.nrecords;
+  ks->recordbytes = h.recordbytes;
+  ks->seeds = (h.flags & KS_SEEDS) != 0;
+
+  ks->locks = calloc(1, sizeof(struct keystore_locks));
+  if(!ks->locks) {
+    keystore_close(ks);
+    return -1;
+  }
+  pthread_mutex_init(&ks->locks->mutex, NULL);
+
+  madvise(ks->base, ks->len, MADV_RANDOM);
+#ifdef MADV_DONTDUMP
+  madvise(ks->base, ks->len, MADV_DONTDUMP);
+#endif
+  return 0;
+}
+
+/*************************************************
+* Name:        keystore_close
+*
+* Description: Unmaps a key store; locked pages are unlocked
+*
+* Arguments:   - keystore *ks: pointer to key store
+**************************************************/
+void keystore_close(keystore *ks)
+{
+  if(ks->base)
+    munmap(ks->base, ks->len);
+  if(ks->locks) {
+    pthread_mutex_destroy(&ks->locks->mutex);
+    free(ks->locks->locked);
+    free(ks->locks->counts);
+    free(ks->locks);
+  }
+  memset(ks, 0, sizeof(*ks));
+}
+
+/*************************************************
+* Name:        keystore_find
+*
+* Description: Looks up the private key with the given id
+*
+* Arguments:   - const keystore *ks: pointer to key store
+*              - uint64_t id: key id
+*
+* Returns pointer to the private key inside the mapping
+* (KYBER_SECRETKEYBYTES bytes) or, in a seed store, to the key seed
+* (KYBER_SEEDKEYBYTES bytes), or NULL if there is no such key
+**************************************************/
+const uint8_t *keystore_find(const keystore *ks, uint64_t id)
+{
+  uint64_t i, j;
+  uint32_t slot;
+  const uint8_t *record;
+
+  for(i = 0, j = clockcache_mix64(id) & ks->mask; i <= ks->mask; i++, j = (j + 1) & ks->mask) {
+    slot = ks->index[j];
+    if(slot == 0 || slot > ks->nrecords)
+      return NULL;
+    record = ks->records + (slot - 1)*ks->recordbytes;
+    if(record_id(record) == id)
+      return record + 8;
+  }
+  return NULL;
+}
+
+/* Record number and the pages first..last of the mapping covering the
+ * private key with the given id */
+static int key_pages(const keystore *ks, uint64_t id, uint64_t *record, size_t *first, size_t *last)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  const uint8_t *sk = keystore_find(ks, id);
+
+  if(!sk)
+    return -1;
+  *record = (uint64_t)(sk - 8 - ks->records) / ks->recordbytes;
+  *first = (size_t)(sk - ks->base) / page;
+  *last = ((size_t)(sk - ks->base) + (ks->seeds ? KYBER_SEEDKEYBYTES : KYBER_SECRETKEYBYTES) - 1) / page;
+  return 0;
+}
+
+/*************************************************
+* Name:        keystore_hot
+*
+* Description: Marks a key as hot: its pages are read ahead and, if lock
+*              is set, locked in memory until keystore_cold of this key;
+*              locking a locked key again has no effect. Pages shared with
+*              other locked keys stay locked until all of them are cold.
+*              Locking is subject to RLIMIT_MEMLOCK.
+*
+* Arguments:   - const keystore *ks: pointer to key store
+*              - uint64_t id: key id
+*              - int lock: nonzero to lock the pages
+*
+* Returns 0 on success, -1 if there is no such key or locking failed
+**************************************************/
+int keystore_hot(const keystore *ks, uint64_t id, int lock)
+{
+  int ret = 0;
+  uint64_t r;
+  size_t i, first, last, page = (size_t)sysconf(_SC_PAGESIZE);
+  struct keystore_locks *l = ks->locks;
+
+  if(key_pages(ks, id, &r, &first, &last))
+    return -1;
+  madvise(ks->base + first*page, (last - first + 1)*page, MADV_WILLNEED);
+  if(!lock)
+    return 0;
+
+  pthread_mutex_lock(&l->mutex);
+  if(!l->locked) {
+    l->locked = calloc(ks->nrecords, 1);
+    l->counts = calloc((ks->len + page - 1) / page, sizeof(uint32_t));
+    if(!l->locked || !l->counts) {
+      free(l->locked);
+      free(l->counts);
+      l->locked = NULL;
+      l->counts = NULL;
+      ret = -1;
+    }
+  }
+  if(ret == 0 && !l->locked[r]) {
+    if(mlock(ks->base + first*page, (last - first + 1)*page))
+      ret = -1;
+    else {
+      l->locked[r] = 1;
+      for(i = first; i <= last; i++)
+        l->counts[i]++;
+    }
+  }
+  pthread_mutex_unlock(&l->mutex);
+  return ret;
+}
+
+/*************************************************
+* Name:        keystore_cold
+*
+* Description: Undoes keystore_hot with lock: unlocks the pages of a key
+*              that no other locked key shares. Keys that are not locked
+*              are left alone.
+*
+* Arguments:   - const keystore *ks: pointer to key store
+*              - uint64_t id: key id
+*
+* Returns 0 on success, -1 if there is no such key
+**************************************************/
+int keystore_cold(const keystore *ks, uint64_t id)
+{
+  uint64_t r;
+  size_t i, first, last, page = (size_t)sysconf(_SC_PAGESIZE);
+  struct keystore_locks *l = ks->locks;
+
+  if(key_pages(ks, id, &r, &first, &last))
+    return -1;
+
+  pthread_mutex_lock(&l->mutex);
+  if(l->locked && l->locked[r]) {
+    l->locked[r] = 0;
+    for(i = first; i <= last; i++)
+      if(--l->counts[i] == 0)
+        munlock(ks->base + i*page, page);
+  }
+  pthread_mutex_unlock(&l->mutex);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_by_id
+*
+* Description: Generates shared secret for given cipher text and the
+*              private key with the given id, read in place from the store;
+*              in a seed store the key is regenerated from its seed for
+*              this one call (see kem_skcache in seedkey.h to keep it)
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - const keystore *ks: pointer to key store
+*              - uint64_t id: key id
+*
+* Returns 0, or -1 if there is no such key (ss is then untouched).
+*
+* On decapsulation failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_by_id(uint8_t *ss, const uint8_t *ct, const keystore *ks, uint64_t id)
+{
+  int ret;
+  const uint8_t *sk = keystore_find(ks, id);
+  uint8_t pk[KYBER_PUBLICKEYBYTES];
+  uint8_t buf[KYBER_SECRETKEYBYTES];
+
+  if(!sk)
+    return -1;
+  if(!ks->seeds)
+    return crypto_kem_dec(ss, ct, sk);
+
+  crypto_kem_keypair_derand(pk, buf, sk);
+  ret = crypto_kem_dec(ss, ct, buf);
+  wipe(buf, sizeof(buf));
+  return ret;
+}
@@ -0,0 +1,54 @@
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+
+/* Read-only store of many private keys in one memory-mapped file. The
+ * file holds a header, an open-addressing hash index from 64-bit key ids
+ * to records and the fixed-size records themselves; opening it maps the
+ * file and checks the header, so it takes the same time for any number of
+ * keys. Keys are used in place and only the pages actually touched are
+ * read from disk. A seed store holds the 64-byte key seeds instead of the
+ * private keys (see seedkey.h), about 44x (Kyber1024) less per key. */
+
+struct keystore_locks;
+
+typedef struct {
+  uint8_t *base;
+  size_t len;
+  const uint32_t *index;
+  uint64_t mask;
+  const uint8_t *records;
+  uint64_t nrecords;
+  uint64_t recordbytes;
+  int seeds;
+  struct keystore_locks *locks;
+} keystore;
+
+#define keystore_create KYBER_NAMESPACE(keystore_create)
+int keystore_create(const char *path, const uint64_t *ids, const uint8_t *sks, size_t n);
+
+#define keystore_create_seeds KYBER_NAMESPACE(keystore_create_seeds)
+int keystore_create_seeds(const char *path, const uint64_t *ids, const uint8_t *seeds, size_t n);
+
+#define keystore_open KYBER_NAMESPACE(keystore_open)
+int keystore_open(keystore *ks, const char *path);
+
+#define keystore_close KYBER_NAMESPACE(keystore_close)
+void keystore_close(keystore *ks);
+
+#define keystore_find KYBER_NAMESPACE(keystore_find)
+const uint8_t *keystore_find(const keystore *ks, uint64_t id);
+
+#define keystore_hot KYBER_NAMESPACE(keystore_hot)
+int keystore_hot(const keystore *ks, uint64_t id, int lock);
+
+#define keystore_cold KYBER_NAMESPACE(keystore_cold)
+int keystore_cold(const keystore *ks, uint64_t id);
+
+#define crypto_kem_dec_by_id KYBER_NAMESPACE(dec_by_id)
+int crypto_kem_dec_by_id(uint8_t *ss, const uint8_t *ct, const keystore *ks, uint64_t id);
+
+#endif
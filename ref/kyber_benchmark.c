@@ -40,18 +40,10 @@ int main() {
     printf("[Heap] SS1: %zu bytes\n", malloc_usable_size(ss1));
     printf("[Heap] SS2: %zu bytes\n", malloc_usable_size(ss2));
 
-    // Estimated stack sizes (static, not precise)
-    size_t stack_keypair = CRYPTO_PUBLICKEYBYTES + CRYPTO_SECRETKEYBYTES;
-    size_t stack_encap   = CRYPTO_PUBLICKEYBYTES + CRYPTO_CIPHERTEXTBYTES + CRYPTO_BYTES;
-    size_t stack_decap   = CRYPTO_SECRETKEYBYTES + CRYPTO_CIPHERTEXTBYTES + CRYPTO_BYTES;
-
-    printf("\n[Static Stack Estimate]\n");
-    printf("  Keypair:       ~ %zu bytes\n", stack_keypair);
-    printf("  Encapsulation: ~ %zu bytes\n", stack_encap);
-    printf("  Decapsulation: ~ %zu bytes\n", stack_decap);
-
-    // Suggest using -fstack-usage for real stack profiling
-    printf("\n[Tip] Use compiler flag -fstack-usage to generate .su files with accurate per-function stack usage.\n");
+    // Stack use is dominated by the polynomial vectors in indcpa.c, not by the
+    // key buffers; measure it with the footprint tool instead of estimating
+    printf("\n[Stack] Run `make footprint` and test/test_footprint<level> test/su<level>/*.su\n"
+           "        for the measured peak stack per operation and per-function frames.\n\n");
 
     // ===== Warm-up =====
     for (int i = 0; i < 10; i++) {
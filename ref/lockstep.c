@@ -0,0 +1,424 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "params.h"
+#include "lockstep.h"
+#include "polyx.h"
+#include "poly.h"
+#include "symmetric.h"
+#include "verify.h"
+#include "randombytes.h"
+
+/*************************************************
+* Name:        gen_entry_x
+*
+* Description: Samples entry (x,y) of the matrix A of every lane;
+*              lanes with the same seed pointer as lane 0 share its
+*              sample, so a group under one public key expands A once
+*
+* Arguments:   - polyx *r: pointer to output polynomials
+*              - const uint8_t *seed[]: pointers to input seeds, one per lane
+*              - uint8_t x: first byte of the XOF input
+*              - uint8_t y: second byte of the XOF input
+**************************************************/
+static void gen_entry_x(polyx *r, const uint8_t *seed[KYBER_LANES], uint8_t x, uint8_t y)
+{
+  unsigned int l;
+  poly a[KYBER_LANES];
+
+  poly_uniform(&a[0], seed[0], x, y);
+  for(l=1;l<KYBER_LANES;l++) {
+    if(seed[l] == seed[0])
+      a[l] = a[0];
+    else
+      poly_uniform(&a[l], seed[l], x, y);
+  }
+  polyx_load(r, a);
+}
+
+/*************************************************
+* Name:        matrix_row_x
+*
+* Description: Row i of the matrix-vector product in the NTT domain,
+*              sampling the row on the fly; same result per lane as
+*              polyvec_basemul_acc_montgomery on that row
+*
+* Arguments:   - polyx *r: pointer to output polynomials
+*              - const uint8_t *seed[]: pointers to input seeds, one per lane
+*              - const polyvecx *v: pointer to input vector in NTT domain
+*              - unsigned int i: row index
+*              - int transposed: boolean deciding whether A or A^T is used
+**************************************************/
+static void matrix_row_x(polyx *r,
+                         const uint8_t *seed[KYBER_LANES],
+                         const polyvecx *v,
+                         unsigned int i,
+                         int transposed)
+{
+  unsigned int j;
+  polyx a, t;
+
+  for(j=0;j<KYBER_K;j++) {
+    if(transposed)
+      gen_entry_x(&a, seed, i, j);
+    else
+      gen_entry_x(&a, seed, j, i);
+
+    if(j == 0) {
+      polyx_basemul_montgomery(r, &a, &v->vec[0]);
+    } else {
+      polyx_basemul_montgomery(&t, &a, &v->vec[j]);
+      polyx_add(r, r, &t);
+    }
+  }
+
+  polyx_reduce(r);
+}
+
+/*************************************************
+* Name:        indcpa_keypair_derand_lockstep
+*
+* Description: Generates KYBER_LANES public and private keys of the
+*              CPA-secure public-key encryption scheme; lane l gives the
+*              same result as indcpa_keypair_derand(pk[l], sk[l], coins[l])
+*
+* Arguments:   - uint8_t *pk[]: pointers to output public keys
+*                               (of length KYBER_INDCPA_PUBLICKEYBYTES bytes)
+*              - uint8_t *sk[]: pointers to output private keys
+*                               (of length KYBER_INDCPA_SECRETKEYBYTES bytes)
+*              - const uint8_t *coins[]: pointers to input randomness
+*                               (of length KYBER_SYMBYTES bytes)
+**************************************************/
+void indcpa_keypair_derand_lockstep(uint8_t *pk[KYBER_LANES],
+                                    uint8_t *sk[KYBER_LANES],
+                                    const uint8_t *coins[KYBER_LANES])
+{
+  unsigned int i, l;
+  uint8_t buf[KYBER_LANES][2*KYBER_SYMBYTES];
+  const uint8_t *publicseed[KYBER_LANES];
+  const uint8_t *noiseseed[KYBER_LANES];
+  uint8_t *out[KYBER_LANES];
+  uint8_t nonce = 0;
+  polyvecx skpv;
+  polyx pkpv, e;
+
+  for(l=0;l<KYBER_LANES;l++) {
+    memcpy(buf[l], coins[l], KYBER_SYMBYTES);
+    buf[l][KYBER_SYMBYTES] = KYBER_K;
+    hash_g(buf[l], buf[l], KYBER_SYMBYTES+1);
+    publicseed[l] = buf[l];
+    noiseseed[l] = buf[l]+KYBER_SYMBYTES;
+  }
+
+  for(i=0;i<KYBER_K;i++)
+    polyx_getnoise_eta1(&skpv.vec[i], noiseseed, nonce++);
+  polyvecx_ntt(&skpv);
+
+  for(i=0;i<KYBER_K;i++) {
+    matrix_row_x(&pkpv, publicseed, &skpv, i, 0);
+    polyx_tomont(&pkpv);
+
+    polyx_getnoise_eta1(&e, noiseseed, nonce++);
+    polyx_ntt(&e);
+    polyx_add(&pkpv, &pkpv, &e);
+    polyx_reduce(&pkpv);
+
+    for(l=0;l<KYBER_LANES;l++)
+      out[l] = pk[l]+i*KYBER_POLYBYTES;
+    polyx_tobytes(out, &pkpv);
+    for(l=0;l<KYBER_LANES;l++)
+      out[l] = sk[l]+i*KYBER_POLYBYTES;
+    polyx_tobytes(out, &skpv.vec[i]);
+  }
+
+  for(l=0;l<KYBER_LANES;l++)
+    memcpy(pk[l]+KYBER_POLYVECBYTES, publicseed[l], KYBER_SYMBYTES);
+}
+
+/*************************************************
+* Name:        indcpa_enc_lockstep
+*
+* Description: Encrypts KYBER_LANES messages with the CPA-secure
+*              public-key encryption scheme; lane l gives the same result
+*              as indcpa_enc(c[l], m[l], pk[l], coins[l])
+*
+* Arguments:   - uint8_t *c[]: pointers to output ciphertexts
+*                              (of length KYBER_INDCPA_BYTES bytes)
+*              - const uint8_t *m[]: pointers to input messages
+*                                    (of length KYBER_INDCPA_MSGBYTES bytes)
+*              - const uint8_t *pk[]: pointers to input public keys
+*                                     (of length KYBER_INDCPA_PUBLICKEYBYTES)
+*              - const uint8_t *coins[]: pointers to input random coins
+*                                        (of length KYBER_SYMBYTES)
+**************************************************/
+void indcpa_enc_lockstep(uint8_t *c[KYBER_LANES],
+                         const uint8_t *m[KYBER_LANES],
+                         const uint8_t *pk[KYBER_LANES],
+                         const uint8_t *coins[KYBER_LANES])
+{
+  unsigned int i, l;
+  const uint8_t *in[KYBER_LANES];
+  uint8_t *out[KYBER_LANES];
+  uint8_t nonce = 0;
+  polyvecx sp, b;
+  polyx v, k, t;
+
+  for(i=0;i<KYBER_K;i++)
+    polyx_getnoise_eta1(&sp.vec[i], coins, nonce++);
+  polyvecx_ntt(&sp);
+
+  // matrix-vector multiplication
+  for(l=0;l<KYBER_LANES;l++)
+    in[l] = pk[l]+KYBER_POLYVECBYTES;
+  for(i=0;i<KYBER_K;i++)
+    matrix_row_x(&b.vec[i], in, &sp, i, 1);
+
+  for(i=0;i<KYBER_K;i++) {
+    for(l=0;l<KYBER_LANES;l++)
+      in[l] = pk[l]+i*KYBER_POLYBYTES;
+    polyx_frombytes(&k, in);
+    if(i == 0) {
+      polyx_basemul_montgomery(&v, &k, &sp.vec[0]);
+    } else {
+      polyx_basemul_montgomery(&t, &k, &sp.vec[i]);
+      polyx_add(&v, &v, &t);
+    }
+  }
+  polyx_reduce(&v);
+
+  polyvecx_invntt_tomont(&b);
+  polyx_invntt_tomont(&v);
+
+  for(i=0;i<KYBER_K;i++) {
+    polyx_getnoise_eta2(&t, coins, nonce++);
+    polyx_add(&b.vec[i], &b.vec[i], &t);
+  }
+  polyx_getnoise_eta2(&t, coins, nonce++);
+  polyx_add(&v, &v, &t);
+  polyx_frommsg(&k, m);
+  polyx_add(&v, &v, &k);
+  polyvecx_reduce(&b);
+  polyx_reduce(&v);
+
+  polyvecx_compress(c, &b);
+  for(l=0;l<KYBER_LANES;l++)
+    out[l] = c[l]+KYBER_POLYVECCOMPRESSEDBYTES;
+  polyx_compress(out, &v);
+}
+
+/*************************************************
+* Name:        indcpa_dec_lockstep
+*
+* Description: Decrypts KYBER_LANES ciphertexts with the CPA-secure
+*              public-key encryption scheme; lane l gives the same result
+*              as indcpa_dec(m[l], c[l], sk[l])
+*
+* Arguments:   - uint8_t *m[]: pointers to output decrypted messages
+*                              (of length KYBER_INDCPA_MSGBYTES)
+*              - const uint8_t *c[]: pointers to input ciphertexts
+*                                    (of length KYBER_INDCPA_BYTES)
+*              - const uint8_t *sk[]: pointers to input secret keys
+*                                     (of length KYBER_INDCPA_SECRETKEYBYTES)
+**************************************************/
+void indcpa_dec_lockstep(uint8_t *m[KYBER_LANES],
+                         const uint8_t *c[KYBER_LANES],
+                         const uint8_t *sk[KYBER_LANES])
+{
+  unsigned int i, l;
+  const uint8_t *in[KYBER_LANES];
+  polyvecx b;
+  polyx v, mp, s, t;
+
+  polyvecx_decompress(&b, c);
+  for(l=0;l<KYBER_LANES;l++)
+    in[l] = c[l]+KYBER_POLYVECCOMPRESSEDBYTES;
+  polyx_decompress(&v, in);
+
+  polyvecx_ntt(&b);
+  for(i=0;i<KYBER_K;i++) {
+    for(l=0;l<KYBER_LANES;l++)
+      in[l] = sk[l]+i*KYBER_POLYBYTES;
+    polyx_frombytes(&s, in);
+    if(i == 0) {
+      polyx_basemul_montgomery(&mp, &s, &b.vec[0]);
+    } else {
+      polyx_basemul_montgomery(&t, &s, &b.vec[i]);
+      polyx_add(&mp, &mp, &t);
+    }
+  }
+  polyx_reduce(&mp);
+  polyx_invntt_tomont(&mp);
+
+  polyx_sub(&mp, &v, &mp);
+  polyx_reduce(&mp);
+
+  polyx_tomsg(m, &mp);
+}
+
+/*************************************************
+* Name:        crypto_kem_keypair_derand_lockstep
+*
+* Description: Generates n public and private keys for CCA-secure Kyber
+*              key encapsulation mechanism, KYBER_LANES at a time; same
+*              output as n calls of crypto_kem_keypair_derand
+*
+* Arguments:   - uint8_t *pk: pointer to output public keys
+*                (an already allocated array of n*KYBER_PUBLICKEYBYTES bytes)
+*              - uint8_t *sk: pointer to output private keys
+*                (an already allocated array of n*KYBER_SECRETKEYBYTES bytes)
+*              - const uint8_t *coins: pointer to input randomness
+*                (an array of n*2*KYBER_SYMBYTES random bytes)
+*              - size_t n: number of key pairs
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_keypair_derand_lockstep(uint8_t *pk,
+                                       uint8_t *sk,
+                                       const uint8_t *coins,
+                                       size_t n)
+{
+  unsigned int l, m;
+  uint8_t pkpad[KYBER_INDCPA_PUBLICKEYBYTES];
+  uint8_t skpad[KYBER_INDCPA_SECRETKEYBYTES];
+  uint8_t *p[KYBER_LANES];
+  uint8_t *s[KYBER_LANES];
+  const uint8_t *c[KYBER_LANES];
+
+  while(n > 0) {
+    m = (n < KYBER_LANES) ? n : KYBER_LANES;
+    for(l=0;l<KYBER_LANES;l++) {
+      p[l] = (l < m) ? pk + l*KYBER_PUBLICKEYBYTES : pkpad;
+      s[l] = (l < m) ? sk + l*KYBER_SECRETKEYBYTES : skpad;
+      c[l] = coins + ((l < m) ? l : 0)*2*KYBER_SYMBYTES;
+    }
+
+    indcpa_keypair_derand_lockstep(p, s, c);
+
+    for(l=0;l<m;l++) {
+      memcpy(s[l]+KYBER_INDCPA_SECRETKEYBYTES, p[l], KYBER_PUBLICKEYBYTES);
+      hash_h(s[l]+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, p[l], KYBER_PUBLICKEYBYTES);
+      /* Value z for pseudo-random output on reject */
+      memcpy(s[l]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES, c[l]+KYBER_SYMBYTES, KYBER_SYMBYTES);
+    }
+
+    pk += m*KYBER_PUBLICKEYBYTES;
+    sk += m*KYBER_SECRETKEYBYTES;
+    coins += m*2*KYBER_SYMBYTES;
+    n -= m;
+  }
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_keypair_lockstep
+*
+* Description: Generates n public and private keys for CCA-secure Kyber
+*              key encapsulation mechanism, KYBER_LANES at a time
+*
+* Arguments:   - uint8_t *pk: pointer to output public keys
+*                (an already allocated array of n*KYBER_PUBLICKEYBYTES bytes)
+*              - uint8_t *sk: pointer to output private keys
+*                (an already allocated array of n*KYBER_SECRETKEYBYTES bytes)
+*              - size_t n: number of key pairs
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_keypair_lockstep(uint8_t *pk,
+                                uint8_t *sk,
+                                size_t n)
+{
+  unsigned int m;
+  uint8_t coins[KYBER_LANES][2*KYBER_SYMBYTES];
+
+  while(n > 0) {
+    m = (n < KYBER_LANES) ? n : KYBER_LANES;
+    randombytes(coins[0], m*2*KYBER_SYMBYTES);
+    crypto_kem_keypair_derand_lockstep(pk, sk, coins[0], m);
+    pk += m*KYBER_PUBLICKEYBYTES;
+    sk += m*KYBER_SECRETKEYBYTES;
+    n -= m;
+  }
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_lockstep
+*
+* Description: Generates shared secrets for n cipher texts, KYBER_LANES at
+*              a time; same output as n calls of crypto_kem_dec. With a
+*              single key (skstride 0) the matrix A is expanded once per
+*              group instead of once per cipher text.
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secrets
+*                (an already allocated array of n*KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher texts
+*                (an array of n*KYBER_CIPHERTEXTBYTES bytes)
+*              - const uint8_t *sk: pointer to input private keys
+*                (KYBER_SECRETKEYBYTES bytes each)
+*              - size_t skstride: distance between consecutive private keys
+*                in bytes; KYBER_SECRETKEYBYTES for n keys, 0 for one key
+*              - size_t n: number of cipher texts
+*
+* Returns 0.
+*
+* On failure, the respective ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_lockstep(uint8_t *ss,
+                            const uint8_t *ct,
+                            const uint8_t *sk,
+                            size_t skstride,
+                            size_t n)
+{
+  unsigned int l, m;
+  int fail;
+  uint8_t buf[KYBER_LANES][2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[KYBER_LANES][2*KYBER_SYMBYTES];
+  uint8_t cmp[KYBER_LANES][KYBER_CIPHERTEXTBYTES];
+  const uint8_t *c[KYBER_LANES];
+  const uint8_t *s[KYBER_LANES];
+  const uint8_t *pk[KYBER_LANES];
+  const uint8_t *msg[KYBER_LANES];
+  const uint8_t *coins[KYBER_LANES];
+  uint8_t *out[KYBER_LANES];
+
+  while(n > 0) {
+    m = (n < KYBER_LANES) ? n : KYBER_LANES;
+    for(l=0;l<KYBER_LANES;l++) {
+      c[l] = ct + ((l < m) ? l : 0)*KYBER_CIPHERTEXTBYTES;
+      s[l] = sk + ((l < m) ? l : 0)*skstride;
+      pk[l] = s[l]+KYBER_INDCPA_SECRETKEYBYTES;
+      msg[l] = out[l] = buf[l];
+      coins[l] = kr[l]+KYBER_SYMBYTES;
+    }
+
+    indcpa_dec_lockstep(out, c, s);
+
+    for(l=0;l<KYBER_LANES;l++) {
+      /* Multitarget countermeasure for coins + contributory KEM */
+      memcpy(buf[l]+KYBER_SYMBYTES, s[l]+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+      hash_g(kr[l], buf[l], 2*KYBER_SYMBYTES);
+      out[l] = cmp[l];
+    }
+
+    /* coins are in kr+KYBER_SYMBYTES */
+    indcpa_enc_lockstep(out, msg, pk, coins);
+
+    for(l=0;l<m;l++) {
+      fail = verify(c[l], cmp[l], KYBER_CIPHERTEXTBYTES);
+      /* Compute rejection key */
+      rkprf(ss+l*KYBER_SSBYTES, s[l]+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES, c[l]);
+      /* Copy true key to return buffer if fail is false */
+      cmov(ss+l*KYBER_SSBYTES, kr[l], KYBER_SYMBYTES, !fail);
+    }
+
+    ss += m*KYBER_SSBYTES;
+    ct += m*KYBER_CIPHERTEXTBYTES;
+    sk += m*skstride;
+    n -= m;
+  }
+
+  return 0;
+}
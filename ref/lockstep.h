@@ -0,0 +1,43 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+#include "polyx.h"
+
+/* Bulk key generation and decapsulation with KYBER_LANES independent
+ * operations in lockstep (see polyx.h): the polynomial arithmetic of all
+ * lanes runs through the same vector instructions, while hashing, matrix
+ * sampling and byte packing stay per lane. Results are identical to those
+ * of the one-by-one functions in kem.h. n need not be a multiple of
+ * KYBER_LANES; a short last group is padded with copies of its first
+ * operation. Needs GCC or Clang vector extensions; the lockstep state
+ * lives on the stack, about 130 KiB for Kyber1024 with 16 lanes. */
+
+#define indcpa_keypair_derand_lockstep KYBER_NAMESPACE(indcpa_keypair_derand_lockstep)
+void indcpa_keypair_derand_lockstep(uint8_t *pk[KYBER_LANES],
+                                    uint8_t *sk[KYBER_LANES],
+                                    const uint8_t *coins[KYBER_LANES]);
+
+#define indcpa_enc_lockstep KYBER_NAMESPACE(indcpa_enc_lockstep)
+void indcpa_enc_lockstep(uint8_t *c[KYBER_LANES],
+                         const uint8_t *m[KYBER_LANES],
+                         const uint8_t *pk[KYBER_LANES],
+                         const uint8_t *coins[KYBER_LANES]);
+
+#define indcpa_dec_lockstep KYBER_NAMESPACE(indcpa_dec_lockstep)
+void indcpa_dec_lockstep(uint8_t *m[KYBER_LANES],
+                         const uint8_t *c[KYBER_LANES],
+                         const uint8_t *sk[KYBER_LANES]);
+
+#define crypto_kem_keypair_derand_lockstep KYBER_NAMESPACE(keypair_derand_lockstep)
+int crypto_kem_keypair_derand_lockstep(uint8_t *pk, uint8_t *sk, const uint8_t *coins, size_t n);
+
+#define crypto_kem_keypair_lockstep KYBER_NAMESPACE(keypair_lockstep)
+int crypto_kem_keypair_lockstep(uint8_t *pk, uint8_t *sk, size_t n);
+
+#define crypto_kem_dec_lockstep KYBER_NAMESPACE(dec_lockstep)
+int crypto_kem_dec_lockstep(uint8_t *ss, const uint8_t *ct, const uint8_t *sk, size_t skstride, size_t n);
+
+#endif
@@ -7,6 +7,9 @@
 #define zetas KYBER_NAMESPACE(zetas)
 extern const int16_t zetas[128];
 
+#define zetas_qinv KYBER_NAMESPACE(zetas_qinv)
+extern const int16_t zetas_qinv[128];
+
 #define ntt KYBER_NAMESPACE(ntt)
 void ntt(int16_t poly[256]);
 
@@ -0,0 +1,220 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "params.h"
+#include "kem.h"
+#include "offline.h"
+#include "verify.h"
+
+typedef struct {
+  uint8_t ct[KYBER_CIPHERTEXTBYTES];
+  uint8_t ss[KYBER_SSBYTES];
+} offline_pair;
+
+/* Ring of ready pairs: count pairs starting at head */
+struct kem_offline {
+  kem_pkctx pk;
+  offline_pair *pairs;
+  size_t capacity;
+  size_t head;
+  size_t count;
+  pthread_mutex_t lock;
+  pthread_cond_t room;
+  pthread_t thread;
+  int background;
+  int stop;
+};
+
+/*************************************************
+* Name:        offline_push
+*
+* Description: Computes one pair outside the lock and stores it
+*
+* Returns 1 if the pair was stored, 0 if the store was full
+**************************************************/
+static int offline_push(kem_offline *o)
+{
+  int stored = 0;
+  offline_pair pair;
+
+  crypto_kem_enc_pkctx(pair.ct, pair.ss, &o->pk);
+
+  pthread_mutex_lock(&o->lock);
+  if(o->count < o->capacity) {
+    o->pairs[(o->head + o->count) % o->capacity] = pair;
+    o->count++;
+    stored = 1;
+  }
+  pthread_mutex_unlock(&o->lock);
+
+  wipe(&pair, sizeof(pair));
+  return stored;
+}
+
+static void *offline_refill(void *arg)
+{
+  kem_offline *o = arg;
+
+  for(;;) {
+    pthread_mutex_lock(&o->lock);
+    while(!o->stop && o->count == o->capacity)
+      pthread_cond_wait(&o->room, &o->lock);
+    if(o->stop) {
+      pthread_mutex_unlock(&o->lock);
+      return NULL;
+    }
+    pthread_mutex_unlock(&o->lock);
+
+    offline_push(o);
+  }
+}
+
+/*************************************************
+* Name:        kem_offline_new
+*
+* Description: Registers a peer public key for online/offline
+*              encapsulation
+*
+* Arguments:   - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - size_t capacity: maximal number of ready pairs (at least 1)
+*              - int background: if nonzero, a thread keeps the store full;
+*                otherwise it is filled with kem_offline_fill
+*
+* Returns the store, or NULL if it could not be created
+**************************************************/
+kem_offline *kem_offline_new(const uint8_t *pk, size_t capacity, int background)
+{
+  kem_offline *o;
+
+  if(capacity == 0)
+    return NULL;
+  o = calloc(1, sizeof(kem_offline));
+  if(!o)
+    return NULL;
+  o->pairs = calloc(capacity, sizeof(offline_pair));
+  if(!o->pairs) {
+    free(o);
+    return NULL;
+  }
+  crypto_kem_pkctx_init(&o->pk, pk);
+  o->capacity = capacity;
+  pthread_mutex_init(&o->lock, NULL);
+  pthread_cond_init(&o->room, NULL);
+
+  if(background) {
+    if(pthread_create(&o->thread, NULL, offline_refill, o)) {
+      kem_offline_free(o);
+      return NULL;
+    }
+    o->background = 1;
+  }
+
+  return o;
+}
+
+/*************************************************
+* Name:        kem_offline_free
+*
+* Description: Stops the background thread, wipes the ready pairs and
+*              frees the store
+*
+* Arguments:   - kem_offline *o: pointer to store (may be NULL)
+**************************************************/
+void kem_offline_free(kem_offline *o)
+{
+  if(!o)
+    return;
+  if(o->background) {
+    pthread_mutex_lock(&o->lock);
+    o->stop = 1;
+    pthread_cond_signal(&o->room);
+    pthread_mutex_unlock(&o->lock);
+    pthread_join(o->thread, NULL);
+  }
+
+  pthread_cond_destroy(&o->room);
+  pthread_mutex_destroy(&o->lock);
+  wipe(o->pairs, o->capacity*sizeof(offline_pair));
+  free(o->pairs);
+  free(o);
+}
+
+/*************************************************
+* Name:        kem_offline_fill
+*
+* Description: Computes up to n pairs in the calling thread, stopping
+*              when the store is full
+*
+* Arguments:   - kem_offline *o: pointer to store
+*              - size_t n: maximal number of pairs to add
+*
+* Returns the number of pairs added
+**************************************************/
+size_t kem_offline_fill(kem_offline *o, size_t n)
+{
+  size_t added = 0;
+
+  while(added < n && offline_push(o))
+    added++;
+
+  return added;
+}
+
+/*************************************************
+* Name:        kem_offline_available
+*
+* Description: Number of ready pairs
+*
+* Arguments:   - kem_offline *o: pointer to store
+**************************************************/
+size_t kem_offline_available(kem_offline *o)
+{
+  size_t n;
+
+  pthread_mutex_lock(&o->lock);
+  n = o->count;
+  pthread_mutex_unlock(&o->lock);
+  return n;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_online
+*
+* Description: Takes a precomputed cipher text and shared secret for the
+*              registered public key out of the store; encapsulates on
+*              the spot if the store is empty
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - kem_offline *o: pointer to store
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_online(uint8_t *ct,
+                          uint8_t *ss,
+                          kem_offline *o)
+{
+  offline_pair *pair;
+
+  pthread_mutex_lock(&o->lock);
+  if(o->count == 0) {
+    pthread_mutex_unlock(&o->lock);
+    return crypto_kem_enc_pkctx(ct, ss, &o->pk);
+  }
+
+  pair = &o->pairs[o->head];
+  memcpy(ct, pair->ct, KYBER_CIPHERTEXTBYTES);
+  memcpy(ss, pair->ss, KYBER_SSBYTES);
+  wipe(pair->ss, KYBER_SSBYTES);
+  o->head = (o->head + 1) % o->capacity;
+  o->count--;
+  pthread_cond_signal(&o->room);
+  pthread_mutex_unlock(&o->lock);
+
+  return 0;
+}
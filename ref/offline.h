@@ -0,0 +1,34 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+
+/* Online/offline encapsulation to a registered peer public key. The
+ * encapsulator chooses all randomness itself, so cipher texts and shared
+ * secrets can be computed before they are needed: a store keeps up to
+ * capacity ready pairs, optionally topped up by a background thread (POSIX
+ * threads), and crypto_kem_enc_online only takes one out. Every pair is
+ * handed out once and its shared secret wiped from the store; an empty
+ * store falls back to encapsulating on the spot. The shared secrets wait
+ * in memory until they are used. */
+
+typedef struct kem_offline kem_offline;
+
+#define kem_offline_new KYBER_NAMESPACE(kem_offline_new)
+kem_offline *kem_offline_new(const uint8_t *pk, size_t capacity, int background);
+
+#define kem_offline_free KYBER_NAMESPACE(kem_offline_free)
+void kem_offline_free(kem_offline *o);
+
+#define kem_offline_fill KYBER_NAMESPACE(kem_offline_fill)
+size_t kem_offline_fill(kem_offline *o, size_t n);
+
+#define kem_offline_available KYBER_NAMESPACE(kem_offline_available)
+size_t kem_offline_available(kem_offline *o);
+
+#define crypto_kem_enc_online KYBER_NAMESPACE(enc_online)
+int crypto_kem_enc_online(uint8_t *ct, uint8_t *ss, kem_offline *o);
+
+#endif
@@ -53,5 +53,7 @@
 /* 32 bytes of additional space to save H(pk) */
 #define KYBER_SECRETKEYBYTES  (KYBER_INDCPA_SECRETKEYBYTES + KYBER_INDCPA_PUBLICKEYBYTES + 2*KYBER_SYMBYTES)
 #define KYBER_CIPHERTEXTBYTES (KYBER_INDCPA_BYTES)
+/* coins of crypto_kem_keypair_derand, from which a key pair is regenerated */
+#define KYBER_SEEDKEYBYTES    (2*KYBER_SYMBYTES)
 
 #endif
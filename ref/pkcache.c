@@ -0,0 +1,164 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "params.h"
+#include "kem.h"
+#include "clockcache.h"
+#include "pkcache.h"
+#include "randombytes.h"
+
+struct kem_pkcache {
+  clockcache *cache;
+  uint64_t salt;
+};
+
+static uint64_t load64(const uint8_t x[8])
+{
+  unsigned int i;
+  uint64_t r = 0;
+
+  for(i=0;i<8;i++)
+    r |= (uint64_t)x[i] << 8*i;
+  return r;
+}
+
+/*************************************************
+* Name:        pkcache_hash
+*
+* Description: Hash of a public key: its seed mixed with the secret salt
+*              of the cache, so that peers cannot pick keys that collide
+*              with other keys
+**************************************************/
+static uint64_t pkcache_hash(const kem_pkcache *c, const uint8_t *pk)
+{
+  unsigned int i;
+  const uint8_t *seed = pk + KYBER_POLYVECBYTES;
+  uint64_t h = c->salt;
+
+  for(i=0;i<KYBER_SYMBYTES/8;i++)
+    h = clockcache_mix64(h ^ load64(seed+8*i));
+  return h;
+}
+
+/*************************************************
+* Name:        kem_pkcache_new
+*
+* Description: Creates an empty cache of expanded public keys
+*
+* Arguments:   - size_t budget: memory budget in bytes; an entry takes
+*                somewhat more than sizeof(kem_expanded_pk) plus
+*                KYBER_PUBLICKEYBYTES
+*
+* Returns the cache, or NULL if the budget does not hold one entry or
+* the cache could not be created
+**************************************************/
+kem_pkcache *kem_pkcache_new(size_t budget)
+{
+  kem_pkcache *c;
+  uint8_t salt[8];
+
+  c = malloc(sizeof(kem_pkcache));
+  if(!c)
+    return NULL;
+  c->cache = clockcache_new(budget, KYBER_PUBLICKEYBYTES, sizeof(kem_expanded_pk));
+  if(!c->cache) {
+    free(c);
+    return NULL;
+  }
+  randombytes(salt, sizeof(salt));
+  c->salt = load64(salt);
+
+  return c;
+}
+
+/*************************************************
+* Name:        kem_pkcache_free
+*
+* Description: Frees a cache
+*
+* Arguments:   - kem_pkcache *c: pointer to cache (may be NULL)
+**************************************************/
+void kem_pkcache_free(kem_pkcache *c)
+{
+  if(!c)
+    return;
+  clockcache_free(c->cache);
+  free(c);
+}
+
+/*************************************************
+* Name:        kem_pkcache_get_stats
+*
+* Description: Reads the counters and fill level of a cache
+*
+* Arguments:   - kem_pkcache *c: pointer to cache
+*              - kem_pkcache_stats *stats: pointer to output statistics
+**************************************************/
+void kem_pkcache_get_stats(kem_pkcache *c, kem_pkcache_stats *stats)
+{
+  clockcache_get_stats(c->cache, stats);
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_cached_derand
+*
+* Description: Generates cipher text and shared secret for given public
+*              key, taking its expanded form from the cache; same output
+*              as crypto_kem_enc_derand
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+*              - kem_pkcache *c: pointer to cache
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_cached_derand(uint8_t *ct,
+                                 uint8_t *ss,
+                                 const uint8_t *pk,
+                                 const uint8_t *coins,
+                                 kem_pkcache *c)
+{
+  uint64_t h;
+  kem_expanded_pk epk;
+
+  h = pkcache_hash(c, pk);
+  if(clockcache_get(c->cache, h, pk, &epk)) {
+    crypto_kem_pk_expand(&epk, pk);
+    clockcache_put(c->cache, h, pk, &epk);
+  }
+
+  return crypto_kem_enc_expanded_derand(ct, ss, &epk, coins);
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_cached
+*
+* Description: Generates cipher text and shared secret for given public
+*              key, taking its expanded form from the cache
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - kem_pkcache *c: pointer to cache
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_cached(uint8_t *ct,
+                          uint8_t *ss,
+                          const uint8_t *pk,
+                          kem_pkcache *c)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  return crypto_kem_enc_cached_derand(ct, ss, pk, coins, c);
+}
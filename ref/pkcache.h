@@ -0,0 +1,36 @@
+#ifndef PKCACHE_H
+#define PKCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+#include "clockcache.h"
+
+/* Cache of expanded peer public keys (kem_expanded_pk) for clients that
+ * encapsulate to the same keys again and again. crypto_kem_enc_cached
+ * looks the public key up and on a hit skips unpacking, sampling of A^T
+ * and hashing of pk; on a miss it expands the key and inserts it, evicting
+ * the least recently used entry (CLOCK approximation) once the memory
+ * budget is used up (see clockcache.h). Entries are hashed by the public
+ * seed and confirmed on the full key. */
+
+typedef struct kem_pkcache kem_pkcache;
+
+typedef clockcache_stats kem_pkcache_stats;
+
+#define kem_pkcache_new KYBER_NAMESPACE(kem_pkcache_new)
+kem_pkcache *kem_pkcache_new(size_t budget);
+
+#define kem_pkcache_free KYBER_NAMESPACE(kem_pkcache_free)
+void kem_pkcache_free(kem_pkcache *c);
+
+#define kem_pkcache_get_stats KYBER_NAMESPACE(kem_pkcache_get_stats)
+void kem_pkcache_get_stats(kem_pkcache *c, kem_pkcache_stats *stats);
+
+#define crypto_kem_enc_cached_derand KYBER_NAMESPACE(enc_cached_derand)
+int crypto_kem_enc_cached_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins, kem_pkcache *c);
+
+#define crypto_kem_enc_cached KYBER_NAMESPACE(enc_cached)
+int crypto_kem_enc_cached(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kem_pkcache *c);
+
+#endif
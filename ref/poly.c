@@ -210,6 +210,81 @@ void poly_tomsg(uint8_t msg[KYBER_INDCPA_MSGBYTES], const poly *a)
   }
 }
 
+/*************************************************
+* Name:        rej_uniform
+*
+* Description: Run rejection sampling on uniform random bytes to generate
+*              uniform random integers mod q
+*
+* Arguments:   - int16_t *r: pointer to output buffer
+*              - unsigned int len: requested number of 16-bit integers (uniform mod q)
+*              - const uint8_t *buf: pointer to input buffer (assumed to be uniformly random bytes)
+*              - unsigned int buflen: length of input buffer in bytes
+*
+* Returns number of sampled 16-bit integers (at most len)
+**************************************************/
+static unsigned int rej_uniform(int16_t *r,
+                                unsigned int len,
+                                const uint8_t *buf,
+                                unsigned int buflen)
+{
+  unsigned int ctr, pos;
+  uint16_t val0, val1;
+
+  ctr = pos = 0;
+  while(ctr < len && pos + 3 <= buflen) {
+    val0 = ((buf[pos+0] >> 0) | ((uint16_t)buf[pos+1] << 8)) & 0xFFF;
+    val1 = ((buf[pos+1] >> 4) | ((uint16_t)buf[pos+2] << 4)) & 0xFFF;
+    pos += 3;
+
+    if(val0 < KYBER_Q)
+      r[ctr++] = val0;
+    if(ctr < len && val1 < KYBER_Q)
+      r[ctr++] = val1;
+  }
+
+  return ctr;
+}
+
+#if(XOF_BLOCKBYTES % 3)
+#error "Implementation of poly_uniform assumes that XOF_BLOCKBYTES is a multiple of 3"
+#endif
+
+#define GEN_MATRIX_NBLOCKS ((12*KYBER_N/8*(1 << 12)/KYBER_Q + XOF_BLOCKBYTES)/XOF_BLOCKBYTES)
+/*************************************************
+* Name:        poly_uniform
+*
+* Description: Sample a polynomial deterministically from a seed and two
+*              indices, with output that looks uniformly random mod q;
+*              entry of the matrix A (or of A^T) used by gen_matrix.
+*              Performs rejection sampling on output of a XOF
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const uint8_t *seed: pointer to input seed
+*                                     (of length KYBER_SYMBYTES bytes)
+*              - uint8_t x: first index absorbed after the seed
+*              - uint8_t y: second index absorbed after the seed
+**************************************************/
+void poly_uniform(poly *r, const uint8_t seed[KYBER_SYMBYTES], uint8_t x, uint8_t y)
+{
+  unsigned int ctr;
+  unsigned int buflen;
+  uint8_t buf[GEN_MATRIX_NBLOCKS*XOF_BLOCKBYTES];
+  xof_state state;
+
+  xof_absorb(&state, seed, x, y);
+
+  xof_squeezeblocks(buf, GEN_MATRIX_NBLOCKS, &state);
+  buflen = GEN_MATRIX_NBLOCKS*XOF_BLOCKBYTES;
+  ctr = rej_uniform(r->coeffs, KYBER_N, buf, buflen);
+
+  while(ctr < KYBER_N) {
+    xof_squeezeblocks(buf, 1, &state);
+    buflen = XOF_BLOCKBYTES;
+    ctr += rej_uniform(r->coeffs + ctr, KYBER_N - ctr, buf, buflen);
+  }
+}
+
 /*************************************************
 * Name:        poly_getnoise_eta1
 *
@@ -4,72 +4,69 @@
 #include "polyvec.h"
 
 /*************************************************
-* Name:        polyvec_compress
+* Name:        poly_compress_du
 *
-* Description: Compress and serialize vector of polynomials
+* Description: Compress and serialize one polynomial of a vector,
+*              with KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K bytes per polynomial
 *
 * Arguments:   - uint8_t *r: pointer to output byte array
-*                            (needs space for KYBER_POLYVECCOMPRESSEDBYTES)
-*              - const polyvec *a: pointer to input vector of polynomials
+*                            (needs space for KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K)
+*              - const poly *a: pointer to input polynomial
 **************************************************/
-void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
+void poly_compress_du(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K], const poly *a)
 {
-  unsigned int i,j,k;
+  unsigned int j,k;
   uint64_t d0;
 
 #if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
   uint16_t t[8];
-  for(i=0;i<KYBER_K;i++) {
-    for(j=0;j<KYBER_N/8;j++) {
-      for(k=0;k<8;k++) {
-        t[k]  = a->vec[i].coeffs[8*j+k];
-        t[k] += ((int16_t)t[k] >> 15) & KYBER_Q;
-/*      t[k]  = ((((uint32_t)t[k] << 11) + KYBER_Q/2)/KYBER_Q) & 0x7ff; */
-        d0 = t[k];
-        d0 <<= 11;
-        d0 += 1664;
-        d0 *= 645084;
-        d0 >>= 31;
-        t[k] = d0 & 0x7ff;
-      }
-
-      r[ 0] = (t[0] >>  0);
-      r[ 1] = (t[0] >>  8) | (t[1] << 3);
-      r[ 2] = (t[1] >>  5) | (t[2] << 6);
-      r[ 3] = (t[2] >>  2);
-      r[ 4] = (t[2] >> 10) | (t[3] << 1);
-      r[ 5] = (t[3] >>  7) | (t[4] << 4);
-      r[ 6] = (t[4] >>  4) | (t[5] << 7);
-      r[ 7] = (t[5] >>  1);
-      r[ 8] = (t[5] >>  9) | (t[6] << 2);
-      r[ 9] = (t[6] >>  6) | (t[7] << 5);
-      r[10] = (t[7] >>  3);
-      r += 11;
+  for(j=0;j<KYBER_N/8;j++) {
+    for(k=0;k<8;k++) {
+      t[k]  = a->coeffs[8*j+k];
+      t[k] += ((int16_t)t[k] >> 15) & KYBER_Q;
+/*    t[k]  = ((((uint32_t)t[k] << 11) + KYBER_Q/2)/KYBER_Q) & 0x7ff; */
+      d0 = t[k];
+      d0 <<= 11;
+      d0 += 1664;
+      d0 *= 645084;
+      d0 >>= 31;
+      t[k] = d0 & 0x7ff;
     }
+
+    r[ 0] = (t[0] >>  0);
+    r[ 1] = (t[0] >>  8) | (t[1] << 3);
+    r[ 2] = (t[1] >>  5) | (t[2] << 6);
+    r[ 3] = (t[2] >>  2);
+    r[ 4] = (t[2] >> 10) | (t[3] << 1);
+    r[ 5] = (t[3] >>  7) | (t[4] << 4);
+    r[ 6] = (t[4] >>  4) | (t[5] << 7);
+    r[ 7] = (t[5] >>  1);
+    r[ 8] = (t[5] >>  9) | (t[6] << 2);
+    r[ 9] = (t[6] >>  6) | (t[7] << 5);
+    r[10] = (t[7] >>  3);
+    r += 11;
   }
 #elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
   uint16_t t[4];
-  for(i=0;i<KYBER_K;i++) {
-    for(j=0;j<KYBER_N/4;j++) {
-      for(k=0;k<4;k++) {
-        t[k]  = a->vec[i].coeffs[4*j+k];
-        t[k] += ((int16_t)t[k] >> 15) & KYBER_Q;
-/*      t[k]  = ((((uint32_t)t[k] << 10) + KYBER_Q/2)/ KYBER_Q) & 0x3ff; */
-        d0 = t[k];
-        d0 <<= 10;
-        d0 += 1665;
-        d0 *= 1290167;
-        d0 >>= 32;
-        t[k] = d0 & 0x3ff;
-      }
-
-      r[0] = (t[0] >> 0);
-      r[1] = (t[0] >> 8) | (t[1] << 2);
-      r[2] = (t[1] >> 6) | (t[2] << 4);
-      r[3] = (t[2] >> 4) | (t[3] << 6);
-      r[4] = (t[3] >> 2);
-      r += 5;
+  for(j=0;j<KYBER_N/4;j++) {
+    for(k=0;k<4;k++) {
+      t[k]  = a->coeffs[4*j+k];
+      t[k] += ((int16_t)t[k] >> 15) & KYBER_Q;
+/*    t[k]  = ((((uint32_t)t[k] << 10) + KYBER_Q/2)/ KYBER_Q) & 0x3ff; */
+      d0 = t[k];
+      d0 <<= 10;
+      d0 += 1665;
+      d0 *= 1290167;
+      d0 >>= 32;
+      t[k] = d0 & 0x3ff;
     }
+
+    r[0] = (t[0] >> 0);
+    r[1] = (t[0] >> 8) | (t[1] << 2);
+    r[2] = (t[1] >> 6) | (t[2] << 4);
+    r[3] = (t[2] >> 4) | (t[3] << 6);
+    r[4] = (t[3] >> 2);
+    r += 5;
   }
 #else
 #error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
@@ -77,56 +74,87 @@ void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
 }
 
 /*************************************************
-* Name:        polyvec_decompress
+* Name:        poly_decompress_du
 *
-* Description: De-serialize and decompress vector of polynomials;
-*              approximate inverse of polyvec_compress
+* Description: De-serialize and decompress one polynomial of a vector;
+*              approximate inverse of poly_compress_du
 *
-* Arguments:   - polyvec *r:       pointer to output vector of polynomials
+* Arguments:   - poly *r:          pointer to output polynomial
 *              - const uint8_t *a: pointer to input byte array
-*                                  (of length KYBER_POLYVECCOMPRESSEDBYTES)
+*                                  (of length KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K)
 **************************************************/
-void polyvec_decompress(polyvec *r, const uint8_t a[KYBER_POLYVECCOMPRESSEDBYTES])
+void poly_decompress_du(poly *r, const uint8_t a[KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K])
 {
-  unsigned int i,j,k;
+  unsigned int j,k;
 
 #if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
   uint16_t t[8];
-  for(i=0;i<KYBER_K;i++) {
-    for(j=0;j<KYBER_N/8;j++) {
-      t[0] = (a[0] >> 0) | ((uint16_t)a[ 1] << 8);
-      t[1] = (a[1] >> 3) | ((uint16_t)a[ 2] << 5);
-      t[2] = (a[2] >> 6) | ((uint16_t)a[ 3] << 2) | ((uint16_t)a[4] << 10);
-      t[3] = (a[4] >> 1) | ((uint16_t)a[ 5] << 7);
-      t[4] = (a[5] >> 4) | ((uint16_t)a[ 6] << 4);
-      t[5] = (a[6] >> 7) | ((uint16_t)a[ 7] << 1) | ((uint16_t)a[8] << 9);
-      t[6] = (a[8] >> 2) | ((uint16_t)a[ 9] << 6);
-      t[7] = (a[9] >> 5) | ((uint16_t)a[10] << 3);
-      a += 11;
-
-      for(k=0;k<8;k++)
-        r->vec[i].coeffs[8*j+k] = ((uint32_t)(t[k] & 0x7FF)*KYBER_Q + 1024) >> 11;
-    }
+  for(j=0;j<KYBER_N/8;j++) {
+    t[0] = (a[0] >> 0) | ((uint16_t)a[ 1] << 8);
+    t[1] = (a[1] >> 3) | ((uint16_t)a[ 2] << 5);
+    t[2] = (a[2] >> 6) | ((uint16_t)a[ 3] << 2) | ((uint16_t)a[4] << 10);
+    t[3] = (a[4] >> 1) | ((uint16_t)a[ 5] << 7);
+    t[4] = (a[5] >> 4) | ((uint16_t)a[ 6] << 4);
+    t[5] = (a[6] >> 7) | ((uint16_t)a[ 7] << 1) | ((uint16_t)a[8] << 9);
+    t[6] = (a[8] >> 2) | ((uint16_t)a[ 9] << 6);
+    t[7] = (a[9] >> 5) | ((uint16_t)a[10] << 3);
+    a += 11;
+
+    for(k=0;k<8;k++)
+      r->coeffs[8*j+k] = ((uint32_t)(t[k] & 0x7FF)*KYBER_Q + 1024) >> 11;
   }
 #elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
   uint16_t t[4];
-  for(i=0;i<KYBER_K;i++) {
-    for(j=0;j<KYBER_N/4;j++) {
-      t[0] = (a[0] >> 0) | ((uint16_t)a[1] << 8);
-      t[1] = (a[1] >> 2) | ((uint16_t)a[2] << 6);
-      t[2] = (a[2] >> 4) | ((uint16_t)a[3] << 4);
-      t[3] = (a[3] >> 6) | ((uint16_t)a[4] << 2);
-      a += 5;
-
-      for(k=0;k<4;k++)
-        r->vec[i].coeffs[4*j+k] = ((uint32_t)(t[k] & 0x3FF)*KYBER_Q + 512) >> 10;
-    }
+  for(j=0;j<KYBER_N/4;j++) {
+    t[0] = (a[0] >> 0) | ((uint16_t)a[1] << 8);
+    t[1] = (a[1] >> 2) | ((uint16_t)a[2] << 6);
+    t[2] = (a[2] >> 4) | ((uint16_t)a[3] << 4);
+    t[3] = (a[3] >> 6) | ((uint16_t)a[4] << 2);
+    a += 5;
+
+    for(k=0;k<4;k++)
+      r->coeffs[4*j+k] = ((uint32_t)(t[k] & 0x3FF)*KYBER_Q + 512) >> 10;
   }
 #else
 #error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
 #endif
 }
 
+/*************************************************
+* Name:        polyvec_compress
+*
+* Description: Compress and serialize vector of polynomials
+*
+* Arguments:   - uint8_t *r: pointer to output byte array
+*                            (needs space for KYBER_POLYVECCOMPRESSEDBYTES)
+*              - const polyvec *a: pointer to input vector of polynomials
+**************************************************/
+void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_K;i++)
+    poly_compress_du(r+i*(KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K), &a->vec[i]);
+}
+
+/*************************************************
+* Name:        polyvec_decompress
+*
+* Description: De-serialize and decompress vector of polynomials;
+*              approximate inverse of polyvec_compress
+*
+* Arguments:   - polyvec *r:       pointer to output vector of polynomials
+*              - const uint8_t *a: pointer to input byte array
+*                                  (of length KYBER_POLYVECCOMPRESSEDBYTES)
+**************************************************/
+void polyvec_decompress(polyvec *r, const uint8_t a[KYBER_POLYVECCOMPRESSEDBYTES])
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_K;i++)
+    poly_decompress_du(&r->vec[i], a+i*(KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K));
+}
+
 /*************************************************
 * Name:        polyvec_tobytes
 *
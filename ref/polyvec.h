@@ -9,6 +9,11 @@ typedef struct{
   poly vec[KYBER_K];
 } polyvec;
 
+#define poly_compress_du KYBER_NAMESPACE(poly_compress_du)
+void poly_compress_du(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K], const poly *a);
+#define poly_decompress_du KYBER_NAMESPACE(poly_decompress_du)
+void poly_decompress_du(poly *r, const uint8_t a[KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K]);
+
 #define polyvec_compress KYBER_NAMESPACE(polyvec_compress)
 void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a);
 #define polyvec_decompress KYBER_NAMESPACE(polyvec_decompress)
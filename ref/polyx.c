@@ -0,0 +1,783 @@
+#include <stdint.h>
+#include "params.h"
+#include "poly.h"
+#include "polyx.h"
+#include "ntt.h"
+#include "reduce.h"
+#include "symmetric.h"
+
+typedef uint16_t vecu16 __attribute__((vector_size(2*KYBER_LANES)));
+typedef uint32_t vecu32 __attribute__((vector_size(4*KYBER_LANES)));
+typedef uint64_t vecu64 __attribute__((vector_size(8*KYBER_LANES)));
+
+#define CONVERT(v, type) __builtin_convertvector(v, type)
+
+/* The helpers below take and return vectors through pointers: passing
+ * them by value would depend on the vector ABI of the target. Those called
+ * from plain loops over the coefficients are kept out of line; inlined,
+ * GCC vectorizes the coefficient loop instead of the lanes and misses the
+ * 16-bit high multiplication. */
+
+/* High half of the lane-wise signed 16x16-bit product; written per lane
+ * so that the vectorizer emits the native instruction (e.g. pmulhw) */
+static void mulhi_x(vec16 *r, const vec16 *a, const vec16 *b)
+{
+  unsigned int l;
+  vec16 x = *a, y = *b, h;
+
+  for(l=0;l<KYBER_LANES;l++)
+    h[l] = ((int32_t)x[l]*y[l]) >> 16;
+  *r = h;
+}
+
+/*************************************************
+* Name:        barrett_reduce_x
+*
+* Description: Lane-wise barrett_reduce; (a*v + 2^25) >> 26 is computed
+*              exactly as ((a*v >> 16) + 2^9) >> 10
+*
+* Arguments:   - vec16 *r: pointer to output centered representatives
+*              - const vec16 *a: pointer to input integers (may equal r)
+**************************************************/
+__attribute__((noinline))
+static void barrett_reduce_x(vec16 *r, const vec16 *a)
+{
+  vec16 t;
+  const vec16 v = (vec16){0} + ((1<<26) + KYBER_Q/2)/KYBER_Q;
+
+  mulhi_x(&t, a, &v);
+  t = (t + (1<<9)) >> 10;
+  *r = CONVERT(CONVERT(*a, vecu16) - CONVERT(t, vecu16)*KYBER_Q, vec16);
+}
+
+/* Lane-wise fqmul; r may equal a or b. The low half of the 32-bit product
+ * cancels exactly against t*q in montgomery_reduce, so only high halves of
+ * 16-bit products are needed. */
+static void fqmul_x(vec16 *r, const vec16 *a, const vec16 *b)
+{
+  vec16 t, h;
+  const vec16 q = (vec16){0} + KYBER_Q;
+
+  t = CONVERT(CONVERT(*a, vecu16)*CONVERT(*b, vecu16)*(uint16_t)QINV, vec16);
+  mulhi_x(&h, a, b);
+  mulhi_x(&t, &t, &q);
+  *r = h - t;
+}
+
+/* Lane-wise fqmul_zeta of ntt.c: product with a constant and its
+ * precomputed product with q^-1 mod 2^16; r may equal a */
+__attribute__((noinline))
+static void fqmul_zeta_x(vec16 *r, const vec16 *a, int16_t b, int16_t bqinv)
+{
+  vec16 t, h;
+  const vec16 q = (vec16){0} + KYBER_Q;
+  const vec16 z = (vec16){0} + b;
+
+  t = CONVERT(CONVERT(*a, vecu16)*(uint16_t)bqinv, vec16);
+  mulhi_x(&h, a, &z);
+  mulhi_x(&t, &t, &q);
+  *r = h - t;
+}
+
+/*************************************************
+* Name:        polyx_load
+*
+* Description: Transposes KYBER_LANES polynomials into lockstep layout
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const poly *a: pointer to KYBER_LANES input polynomials
+**************************************************/
+void polyx_load(polyx *r, const poly a[KYBER_LANES])
+{
+  unsigned int i, l;
+
+  for(i=0;i<KYBER_N;i++)
+    for(l=0;l<KYBER_LANES;l++)
+      r->coeffs[i][l] = a[l].coeffs[i];
+}
+
+/*************************************************
+* Name:        polyx_store
+*
+* Description: Transposes a lockstep polynomial back into KYBER_LANES
+*              polynomials
+*
+* Arguments:   - poly *a: pointer to KYBER_LANES output polynomials
+*              - const polyx *r: pointer to input lockstep polynomial
+**************************************************/
+void polyx_store(poly a[KYBER_LANES], const polyx *r)
+{
+  unsigned int i, l;
+
+  for(i=0;i<KYBER_N;i++)
+    for(l=0;l<KYBER_LANES;l++)
+      a[l].coeffs[i] = r->coeffs[i][l];
+}
+
+/*************************************************
+* Name:        polyx_compress
+*
+* Description: Compression and subsequent serialization of a lockstep
+*              polynomial, lane l to r[l]; see poly_compress
+*
+* Arguments:   - uint8_t *r: KYBER_LANES pointers to output byte arrays
+*                            (of length KYBER_POLYCOMPRESSEDBYTES)
+*              - const polyx *a: pointer to input lockstep polynomial
+**************************************************/
+void polyx_compress(uint8_t *r[KYBER_LANES], const polyx *a)
+{
+  unsigned int i,j,l;
+  vec16 u;
+  vecu32 d0;
+  vecu16 t[8];
+  uint8_t *s;
+
+  for(i=0;i<KYBER_N/8;i++) {
+    for(j=0;j<8;j++) {
+      // map to positive standard representatives
+      u  = a->coeffs[8*i+j];
+      u += (u >> 15) & KYBER_Q;
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+      d0 = CONVERT(u, vecu32) << 4;
+      d0 += 1665;
+      d0 *= 80635;
+      d0 >>= 28;
+      t[j] = CONVERT(d0 & 0xf, vecu16);
+#elif (KYBER_POLYCOMPRESSEDBYTES == 160)
+      d0 = CONVERT(u, vecu32) << 5;
+      d0 += 1664;
+      d0 *= 40318;
+      d0 >>= 27;
+      t[j] = CONVERT(d0 & 0x1f, vecu16);
+#else
+#error "KYBER_POLYCOMPRESSEDBYTES needs to be in {128, 160}"
+#endif
+    }
+
+    for(l=0;l<KYBER_LANES;l++) {
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+      s = r[l] + 4*i;
+      s[0] = t[0][l] | (t[1][l] << 4);
+      s[1] = t[2][l] | (t[3][l] << 4);
+      s[2] = t[4][l] | (t[5][l] << 4);
+      s[3] = t[6][l] | (t[7][l] << 4);
+#else
+      s = r[l] + 5*i;
+      s[0] = (t[0][l] >> 0) | (t[1][l] << 5);
+      s[1] = (t[1][l] >> 3) | (t[2][l] << 2) | (t[3][l] << 7);
+      s[2] = (t[3][l] >> 1) | (t[4][l] << 4);
+      s[3] = (t[4][l] >> 4) | (t[5][l] << 1) | (t[6][l] << 6);
+      s[4] = (t[6][l] >> 2) | (t[7][l] << 3);
+#endif
+    }
+  }
+}
+
+/*************************************************
+* Name:        polyx_decompress
+*
+* Description: De-serialization and subsequent decompression of
+*              KYBER_LANES polynomials into lockstep layout; see
+*              poly_decompress
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const uint8_t *a: KYBER_LANES pointers to input byte arrays
+*                                  (of length KYBER_POLYCOMPRESSEDBYTES)
+**************************************************/
+void polyx_decompress(polyx *r, const uint8_t *a[KYBER_LANES])
+{
+  unsigned int i,j,l;
+  vecu32 t[8];
+  const uint8_t *s;
+
+  for(i=0;i<KYBER_N/8;i++) {
+    for(l=0;l<KYBER_LANES;l++) {
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+      s = a[l] + 4*i;
+      t[0][l] = s[0] & 15;
+      t[1][l] = s[0] >> 4;
+      t[2][l] = s[1] & 15;
+      t[3][l] = s[1] >> 4;
+      t[4][l] = s[2] & 15;
+      t[5][l] = s[2] >> 4;
+      t[6][l] = s[3] & 15;
+      t[7][l] = s[3] >> 4;
+#elif (KYBER_POLYCOMPRESSEDBYTES == 160)
+      s = a[l] + 5*i;
+      t[0][l] = (s[0] >> 0);
+      t[1][l] = (uint8_t)((s[0] >> 5) | (s[1] << 3));
+      t[2][l] = (s[1] >> 2);
+      t[3][l] = (uint8_t)((s[1] >> 7) | (s[2] << 1));
+      t[4][l] = (uint8_t)((s[2] >> 4) | (s[3] << 4));
+      t[5][l] = (s[3] >> 1);
+      t[6][l] = (uint8_t)((s[3] >> 6) | (s[4] << 2));
+      t[7][l] = (s[4] >> 3);
+#else
+#error "KYBER_POLYCOMPRESSEDBYTES needs to be in {128, 160}"
+#endif
+    }
+
+    for(j=0;j<8;j++) {
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+      r->coeffs[8*i+j] = CONVERT((t[j]*KYBER_Q + 8) >> 4, vec16);
+#else
+      r->coeffs[8*i+j] = CONVERT(((t[j] & 31)*KYBER_Q + 16) >> 5, vec16);
+#endif
+    }
+  }
+}
+
+/*************************************************
+* Name:        polyx_tobytes
+*
+* Description: Serialization of a lockstep polynomial, lane l to r[l];
+*              see poly_tobytes
+*
+* Arguments:   - uint8_t *r: KYBER_LANES pointers to output byte arrays
+*                            (of length KYBER_POLYBYTES)
+*              - const polyx *a: pointer to input lockstep polynomial
+**************************************************/
+void polyx_tobytes(uint8_t *r[KYBER_LANES], const polyx *a)
+{
+  unsigned int l;
+  poly t[KYBER_LANES];
+
+  polyx_store(t, a);
+  for(l=0;l<KYBER_LANES;l++)
+    poly_tobytes(r[l], &t[l]);
+}
+
+/*************************************************
+* Name:        polyx_frombytes
+*
+* Description: De-serialization of KYBER_LANES polynomials into lockstep
+*              layout; see poly_frombytes
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const uint8_t *a: KYBER_LANES pointers to input byte arrays
+*                                  (of length KYBER_POLYBYTES)
+**************************************************/
+void polyx_frombytes(polyx *r, const uint8_t *a[KYBER_LANES])
+{
+  unsigned int l;
+  poly t[KYBER_LANES];
+
+  for(l=0;l<KYBER_LANES;l++)
+    poly_frombytes(&t[l], a[l]);
+  polyx_load(r, t);
+}
+
+/*************************************************
+* Name:        polyx_frommsg
+*
+* Description: Convert KYBER_LANES 32-byte messages to a lockstep
+*              polynomial; see poly_frommsg
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const uint8_t *msg: KYBER_LANES pointers to input messages
+**************************************************/
+void polyx_frommsg(polyx *r, const uint8_t *msg[KYBER_LANES])
+{
+  unsigned int l;
+  poly t[KYBER_LANES];
+
+  for(l=0;l<KYBER_LANES;l++)
+    poly_frommsg(&t[l], msg[l]);
+  polyx_load(r, t);
+}
+
+/*************************************************
+* Name:        polyx_tomsg
+*
+* Description: Convert a lockstep polynomial to KYBER_LANES 32-byte
+*              messages; see poly_tomsg
+*
+* Arguments:   - uint8_t *msg: KYBER_LANES pointers to output messages
+*              - const polyx *a: pointer to input lockstep polynomial
+**************************************************/
+void polyx_tomsg(uint8_t *msg[KYBER_LANES], const polyx *a)
+{
+  unsigned int i,j,l;
+  vecu32 t;
+  vecu32 m;
+
+  for(i=0;i<KYBER_N/8;i++) {
+    m = (vecu32){0};
+    for(j=0;j<8;j++) {
+      t  = CONVERT(a->coeffs[8*i+j], vecu32);
+      t <<= 1;
+      t += 1665;
+      t *= 80635;
+      t >>= 28;
+      t &= 1;
+      m |= t << j;
+    }
+    for(l=0;l<KYBER_LANES;l++)
+      msg[l][i] = m[l];
+  }
+}
+
+/*************************************************
+* Name:        cbd2_x
+*
+* Description: Lane-wise cbd2: lane l of r is sampled from buf[l]
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - uint8_t *buf: KYBER_LANES input byte arrays
+**************************************************/
+static void cbd2_x(polyx *r, uint8_t buf[KYBER_LANES][2*KYBER_N/4])
+{
+  unsigned int i,j,l;
+  const uint8_t *s;
+  vecu32 t,d;
+  vec16 a,b;
+
+  for(i=0;i<KYBER_N/8;i++) {
+    for(l=0;l<KYBER_LANES;l++) {
+      s = buf[l] + 4*i;
+      t[l] = (uint32_t)s[0] | (uint32_t)s[1] << 8 | (uint32_t)s[2] << 16 | (uint32_t)s[3] << 24;
+    }
+    d  = t & 0x55555555;
+    d += (t>>1) & 0x55555555;
+
+    for(j=0;j<8;j++) {
+      a = CONVERT((d >> (4*j+0)) & 0x3, vec16);
+      b = CONVERT((d >> (4*j+2)) & 0x3, vec16);
+      r->coeffs[8*i+j] = a - b;
+    }
+  }
+}
+
+#if KYBER_ETA1 == 3
+/*************************************************
+* Name:        cbd3_x
+*
+* Description: Lane-wise cbd3: lane l of r is sampled from buf[l]
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - uint8_t *buf: KYBER_LANES input byte arrays
+**************************************************/
+static void cbd3_x(polyx *r, uint8_t buf[KYBER_LANES][3*KYBER_N/4])
+{
+  unsigned int i,j,l;
+  const uint8_t *s;
+  vecu32 t,d;
+  vec16 a,b;
+
+  for(i=0;i<KYBER_N/4;i++) {
+    for(l=0;l<KYBER_LANES;l++) {
+      s = buf[l] + 3*i;
+      t[l] = (uint32_t)s[0] | (uint32_t)s[1] << 8 | (uint32_t)s[2] << 16;
+    }
+    d  = t & 0x00249249;
+    d += (t>>1) & 0x00249249;
+    d += (t>>2) & 0x00249249;
+
+    for(j=0;j<4;j++) {
+      a = CONVERT((d >> (6*j+0)) & 0x7, vec16);
+      b = CONVERT((d >> (6*j+3)) & 0x7, vec16);
+      r->coeffs[4*i+j] = a - b;
+    }
+  }
+}
+#endif
+
+/*************************************************
+* Name:        polyx_getnoise_eta1
+*
+* Description: Sample KYBER_LANES polynomials from a centered binomial
+*              distribution with parameter KYBER_ETA1, lane l from the PRF
+*              output of seed[l] and nonce; see poly_getnoise_eta1
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const uint8_t *seed: KYBER_LANES pointers to input seeds
+*                                     (of length KYBER_SYMBYTES bytes)
+*              - uint8_t nonce: one-byte input nonce
+**************************************************/
+void polyx_getnoise_eta1(polyx *r, const uint8_t *seed[KYBER_LANES], uint8_t nonce)
+{
+  unsigned int l;
+  uint8_t buf[KYBER_LANES][KYBER_ETA1*KYBER_N/4];
+
+  for(l=0;l<KYBER_LANES;l++)
+    prf(buf[l], sizeof(buf[l]), seed[l], nonce);
+#if KYBER_ETA1 == 2
+  cbd2_x(r, buf);
+#elif KYBER_ETA1 == 3
+  cbd3_x(r, buf);
+#else
+#error "This implementation requires eta1 in {2,3}"
+#endif
+}
+
+/*************************************************
+* Name:        polyx_getnoise_eta2
+*
+* Description: Sample KYBER_LANES polynomials from a centered binomial
+*              distribution with parameter KYBER_ETA2, lane l from the PRF
+*              output of seed[l] and nonce; see poly_getnoise_eta2
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const uint8_t *seed: KYBER_LANES pointers to input seeds
+*                                     (of length KYBER_SYMBYTES bytes)
+*              - uint8_t nonce: one-byte input nonce
+**************************************************/
+void polyx_getnoise_eta2(polyx *r, const uint8_t *seed[KYBER_LANES], uint8_t nonce)
+{
+  unsigned int l;
+  uint8_t buf[KYBER_LANES][KYBER_ETA2*KYBER_N/4];
+
+  for(l=0;l<KYBER_LANES;l++)
+    prf(buf[l], sizeof(buf[l]), seed[l], nonce);
+#if KYBER_ETA2 == 2
+  cbd2_x(r, buf);
+#else
+#error "This implementation requires eta2 = 2"
+#endif
+}
+
+/*************************************************
+* Name:        polyx_ntt
+*
+* Description: Forward NTT of all lanes followed by Barrett reduction;
+*              see poly_ntt
+*
+* Arguments:   - polyx *r: pointer to in/output lockstep polynomial
+**************************************************/
+void polyx_ntt(polyx *r)
+{
+  unsigned int len, start, j, k;
+  int16_t zeta, zetaqinv;
+  vec16 t;
+
+  k = 1;
+  for(len = 128; len >= 2; len >>= 1) {
+    for(start = 0; start < 256; start = j + len) {
+      zeta = zetas[k];
+      zetaqinv = zetas_qinv[k++];
+      for(j = start; j < start + len; j++) {
+        fqmul_zeta_x(&t, &r->coeffs[j + len], zeta, zetaqinv);
+        r->coeffs[j + len] = r->coeffs[j] - t;
+        r->coeffs[j] = r->coeffs[j] + t;
+      }
+    }
+  }
+
+  polyx_reduce(r);
+}
+
+/*************************************************
+* Name:        polyx_invntt_tomont
+*
+* Description: Inverse NTT of all lanes and multiplication by the
+*              Montgomery factor 2^16; see poly_invntt_tomont
+*
+* Arguments:   - polyx *r: pointer to in/output lockstep polynomial
+**************************************************/
+void polyx_invntt_tomont(polyx *r)
+{
+  unsigned int start, len, j, k;
+  int16_t zeta, zetaqinv;
+  vec16 t, u;
+  const int16_t f = 1441; // mont^2/128
+  const int16_t fqinv = -10079; // f*QINV mod 2^16
+
+  k = 127;
+  for(len = 2; len <= 128; len <<= 1) {
+    for(start = 0; start < 256; start = j + len) {
+      zeta = zetas[k];
+      zetaqinv = zetas_qinv[k--];
+      for(j = start; j < start + len; j++) {
+        t = r->coeffs[j];
+        u = t + r->coeffs[j + len];
+        barrett_reduce_x(&r->coeffs[j], &u);
+        r->coeffs[j + len] = r->coeffs[j + len] - t;
+        fqmul_zeta_x(&r->coeffs[j + len], &r->coeffs[j + len], zeta, zetaqinv);
+      }
+    }
+  }
+
+  for(j = 0; j < 256; j++)
+    fqmul_zeta_x(&r->coeffs[j], &r->coeffs[j], f, fqinv);
+}
+
+/* Lane-wise basemul of ntt.c */
+static void basemul_x(vec16 r[2], const vec16 a[2], const vec16 b[2], int16_t zeta)
+{
+  vec16 t, z;
+
+  z = (vec16){0} + zeta;
+  fqmul_x(&r[0], &a[1], &b[1]);
+  fqmul_x(&r[0], &r[0], &z);
+  fqmul_x(&t, &a[0], &b[0]);
+  r[0] += t;
+  fqmul_x(&r[1], &a[0], &b[1]);
+  fqmul_x(&t, &a[1], &b[0]);
+  r[1] += t;
+}
+
+/*************************************************
+* Name:        polyx_basemul_montgomery
+*
+* Description: Multiplication of two lockstep polynomials in NTT domain;
+*              see poly_basemul_montgomery
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const polyx *a: pointer to first input lockstep polynomial
+*              - const polyx *b: pointer to second input lockstep polynomial
+**************************************************/
+void polyx_basemul_montgomery(polyx *r, const polyx *a, const polyx *b)
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_N/4;i++) {
+    basemul_x(&r->coeffs[4*i], &a->coeffs[4*i], &b->coeffs[4*i], zetas[64+i]);
+    basemul_x(&r->coeffs[4*i+2], &a->coeffs[4*i+2], &b->coeffs[4*i+2], -zetas[64+i]);
+  }
+}
+
+/*************************************************
+* Name:        polyx_tomont
+*
+* Description: Inplace conversion of all coefficients of all lanes to
+*              Montgomery domain; see poly_tomont
+*
+* Arguments:   - polyx *r: pointer to in/output lockstep polynomial
+**************************************************/
+void polyx_tomont(polyx *r)
+{
+  unsigned int i;
+  const int16_t f = (1ULL << 32) % KYBER_Q;
+  const int16_t fqinv = 20553; // f*QINV mod 2^16
+
+  for(i=0;i<KYBER_N;i++)
+    fqmul_zeta_x(&r->coeffs[i], &r->coeffs[i], f, fqinv);
+}
+
+/*************************************************
+* Name:        polyx_reduce
+*
+* Description: Applies Barrett reduction to all coefficients of all lanes;
+*              see poly_reduce
+*
+* Arguments:   - polyx *r: pointer to in/output lockstep polynomial
+**************************************************/
+void polyx_reduce(polyx *r)
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_N;i++)
+    barrett_reduce_x(&r->coeffs[i], &r->coeffs[i]);
+}
+
+/*************************************************
+* Name:        polyx_add
+*
+* Description: Add two lockstep polynomials; no modular reduction
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const polyx *a: pointer to first input lockstep polynomial
+*              - const polyx *b: pointer to second input lockstep polynomial
+**************************************************/
+void polyx_add(polyx *r, const polyx *a, const polyx *b)
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_N;i++)
+    r->coeffs[i] = a->coeffs[i] + b->coeffs[i];
+}
+
+/*************************************************
+* Name:        polyx_sub
+*
+* Description: Subtract two lockstep polynomials; no modular reduction
+*
+* Arguments:   - polyx *r: pointer to output lockstep polynomial
+*              - const polyx *a: pointer to first input lockstep polynomial
+*              - const polyx *b: pointer to second input lockstep polynomial
+**************************************************/
+void polyx_sub(polyx *r, const polyx *a, const polyx *b)
+{
+  unsigned int i;
+
+  for(i=0;i<KYBER_N;i++)
+    r->coeffs[i] = a->coeffs[i] - b->coeffs[i];
+}
+
+/*************************************************
+* Name:        polyvecx_compress
+*
+* Description: Compress and serialize a lockstep vector of polynomials,
+*              lane l to r[l]; see polyvec_compress
+*
+* Arguments:   - uint8_t *r: KYBER_LANES pointers to output byte arrays
+*                            (of length KYBER_POLYVECCOMPRESSEDBYTES)
+*              - const polyvecx *a: pointer to input lockstep vector
+**************************************************/
+void polyvecx_compress(uint8_t *r[KYBER_LANES], const polyvecx *a)
+{
+  unsigned int i,j,k,l;
+  vec16 u;
+  vecu64 d0;
+  uint8_t *s;
+
+#if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
+  vecu16 t[8];
+  for(i=0;i<KYBER_K;i++) {
+    for(j=0;j<KYBER_N/8;j++) {
+      for(k=0;k<8;k++) {
+        u  = a->vec[i].coeffs[8*j+k];
+        u += (u >> 15) & KYBER_Q;
+        d0 = CONVERT(u, vecu64);
+        d0 <<= 11;
+        d0 += 1664;
+        d0 *= 645084;
+        d0 >>= 31;
+        t[k] = CONVERT(d0 & 0x7ff, vecu16);
+      }
+
+      for(l=0;l<KYBER_LANES;l++) {
+        s = r[l] + 352*i + 11*j;
+        s[ 0] = (t[0][l] >>  0);
+        s[ 1] = (t[0][l] >>  8) | (t[1][l] << 3);
+        s[ 2] = (t[1][l] >>  5) | (t[2][l] << 6);
+        s[ 3] = (t[2][l] >>  2);
+        s[ 4] = (t[2][l] >> 10) | (t[3][l] << 1);
+        s[ 5] = (t[3][l] >>  7) | (t[4][l] << 4);
+        s[ 6] = (t[4][l] >>  4) | (t[5][l] << 7);
+        s[ 7] = (t[5][l] >>  1);
+        s[ 8] = (t[5][l] >>  9) | (t[6][l] << 2);
+        s[ 9] = (t[6][l] >>  6) | (t[7][l] << 5);
+        s[10] = (t[7][l] >>  3);
+      }
+    }
+  }
+#elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
+  vecu16 t[4];
+  for(i=0;i<KYBER_K;i++) {
+    for(j=0;j<KYBER_N/4;j++) {
+      for(k=0;k<4;k++) {
+        u  = a->vec[i].coeffs[4*j+k];
+        u += (u >> 15) & KYBER_Q;
+        d0 = CONVERT(u, vecu64);
+        d0 <<= 10;
+        d0 += 1665;
+        d0 *= 1290167;
+        d0 >>= 32;
+        t[k] = CONVERT(d0 & 0x3ff, vecu16);
+      }
+
+      for(l=0;l<KYBER_LANES;l++) {
+        s = r[l] + 320*i + 5*j;
+        s[0] = (t[0][l] >> 0);
+        s[1] = (t[0][l] >> 8) | (t[1][l] << 2);
+        s[2] = (t[1][l] >> 6) | (t[2][l] << 4);
+        s[3] = (t[2][l] >> 4) | (t[3][l] << 6);
+        s[4] = (t[3][l] >> 2);
+      }
+    }
+  }
+#else
+#error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
+#endif
+}
+
+/*************************************************
+* Name:        polyvecx_decompress
+*
+* Description: De-serialize and decompress KYBER_LANES vectors of
+*              polynomials into lockstep layout; see polyvec_decompress
+*
+* Arguments:   - polyvecx *r: pointer to output lockstep vector
+*              - const uint8_t *a: KYBER_LANES pointers to input byte arrays
+*                                  (of length KYBER_POLYVECCOMPRESSEDBYTES)
+**************************************************/
+void polyvecx_decompress(polyvecx *r, const uint8_t *a[KYBER_LANES])
+{
+  unsigned int i,j,k,l;
+  const uint8_t *s;
+
+#if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
+  vecu32 t[8];
+  for(i=0;i<KYBER_K;i++) {
+    for(j=0;j<KYBER_N/8;j++) {
+      for(l=0;l<KYBER_LANES;l++) {
+        s = a[l] + 352*i + 11*j;
+        t[0][l] = (s[0] >> 0) | ((uint16_t)s[ 1] << 8);
+        t[1][l] = (s[1] >> 3) | ((uint16_t)s[ 2] << 5);
+        t[2][l] = (s[2] >> 6) | ((uint16_t)s[ 3] << 2) | ((uint16_t)s[4] << 10);
+        t[3][l] = (s[4] >> 1) | ((uint16_t)s[ 5] << 7);
+        t[4][l] = (s[5] >> 4) | ((uint16_t)s[ 6] << 4);
+        t[5][l] = (s[6] >> 7) | ((uint16_t)s[ 7] << 1) | ((uint16_t)s[8] << 9);
+        t[6][l] = (s[8] >> 2) | ((uint16_t)s[ 9] << 6);
+        t[7][l] = (s[9] >> 5) | ((uint16_t)s[10] << 3);
+      }
+
+      for(k=0;k<8;k++)
+        r->vec[i].coeffs[8*j+k] = CONVERT(((t[k] & 0x7FF)*KYBER_Q + 1024) >> 11, vec16);
+    }
+  }
+#elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
+  vecu32 t[4];
+  for(i=0;i<KYBER_K;i++) {
+    for(j=0;j<KYBER_N/4;j++) {
+      for(l=0;l<KYBER_LANES;l++) {
+        s = a[l] + 320*i + 5*j;
+        t[0][l] = (s[0] >> 0) | ((uint16_t)s[1] << 8);
+        t[1][l] = (s[1] >> 2) | ((uint16_t)s[2] << 6);
+        t[2][l] = (s[2] >> 4) | ((uint16_t)s[3] << 4);
+        t[3][l] = (s[3] >> 6) | ((uint16_t)s[4] << 2);
+      }
+
+      for(k=0;k<4;k++)
+        r->vec[i].coeffs[4*j+k] = CONVERT(((t[k] & 0x3FF)*KYBER_Q + 512) >> 10, vec16);
+    }
+  }
+#else
+#error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
+#endif
+}
+
+/*************************************************
+* Name:        polyvecx_ntt
+*
+* Description: Apply forward NTT to all elements of a lockstep vector
+*
+* Arguments:   - polyvecx *r: pointer to in/output lockstep vector
+**************************************************/
+void polyvecx_ntt(polyvecx *r)
+{
+  unsigned int i;
+  for(i=0;i<KYBER_K;i++)
+    polyx_ntt(&r->vec[i]);
+}
+
+/*************************************************
+* Name:        polyvecx_invntt_tomont
+*
+* Description: Apply inverse NTT to all elements of a lockstep vector and
+*              multiply by Montgomery factor 2^16
+*
+* Arguments:   - polyvecx *r: pointer to in/output lockstep vector
+**************************************************/
+void polyvecx_invntt_tomont(polyvecx *r)
+{
+  unsigned int i;
+  for(i=0;i<KYBER_K;i++)
+    polyx_invntt_tomont(&r->vec[i]);
+}
+
+/*************************************************
+* Name:        polyvecx_reduce
+*
+* Description: Applies Barrett reduction to all elements of a lockstep
+*              vector
+*
+* Arguments:   - polyvecx *r: pointer to in/output lockstep vector
+**************************************************/
+void polyvecx_reduce(polyvecx *r)
+{
+  unsigned int i;
+  for(i=0;i<KYBER_K;i++)
+    polyx_reduce(&r->vec[i]);
+}
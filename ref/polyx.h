@@ -0,0 +1,91 @@
+#ifndef POLYX_H
+#define POLYX_H
+
+#include <stdint.h>
+#include "params.h"
+#include "poly.h"
+
+/*
+ * Lockstep layout for KYBER_LANES independent operations: lane l of
+ * coeffs[i] holds coefficient i of the polynomial of operation l. Every
+ * function does, lane by lane, exactly what its counterpart in poly.c or
+ * polyvec.c does, so the results are bit-identical; the arithmetic is
+ * written with GCC/Clang vector extensions and runs on whatever SIMD unit
+ * the target has. Byte (un)packing is done per lane. Functions taking or
+ * returning bytes take one pointer per lane; lanes may share an input.
+ */
+
+#ifndef KYBER_LANES
+#define KYBER_LANES 16
+#endif
+
+#if (KYBER_LANES != 8) && (KYBER_LANES != 16)
+#error "KYBER_LANES must be 8 or 16"
+#endif
+
+typedef int16_t vec16 __attribute__((vector_size(2*KYBER_LANES)));
+
+typedef struct {
+  vec16 coeffs[KYBER_N];
+} polyx;
+
+typedef struct {
+  polyx vec[KYBER_K];
+} polyvecx;
+
+#define polyx_load KYBER_NAMESPACE(polyx_load)
+void polyx_load(polyx *r, const poly a[KYBER_LANES]);
+#define polyx_store KYBER_NAMESPACE(polyx_store)
+void polyx_store(poly a[KYBER_LANES], const polyx *r);
+
+#define polyx_compress KYBER_NAMESPACE(polyx_compress)
+void polyx_compress(uint8_t *r[KYBER_LANES], const polyx *a);
+#define polyx_decompress KYBER_NAMESPACE(polyx_decompress)
+void polyx_decompress(polyx *r, const uint8_t *a[KYBER_LANES]);
+
+#define polyx_tobytes KYBER_NAMESPACE(polyx_tobytes)
+void polyx_tobytes(uint8_t *r[KYBER_LANES], const polyx *a);
+#define polyx_frombytes KYBER_NAMESPACE(polyx_frombytes)
+void polyx_frombytes(polyx *r, const uint8_t *a[KYBER_LANES]);
+
+#define polyx_frommsg KYBER_NAMESPACE(polyx_frommsg)
+void polyx_frommsg(polyx *r, const uint8_t *msg[KYBER_LANES]);
+#define polyx_tomsg KYBER_NAMESPACE(polyx_tomsg)
+void polyx_tomsg(uint8_t *msg[KYBER_LANES], const polyx *a);
+
+#define polyx_getnoise_eta1 KYBER_NAMESPACE(polyx_getnoise_eta1)
+void polyx_getnoise_eta1(polyx *r, const uint8_t *seed[KYBER_LANES], uint8_t nonce);
+#define polyx_getnoise_eta2 KYBER_NAMESPACE(polyx_getnoise_eta2)
+void polyx_getnoise_eta2(polyx *r, const uint8_t *seed[KYBER_LANES], uint8_t nonce);
+
+#define polyx_ntt KYBER_NAMESPACE(polyx_ntt)
+void polyx_ntt(polyx *r);
+#define polyx_invntt_tomont KYBER_NAMESPACE(polyx_invntt_tomont)
+void polyx_invntt_tomont(polyx *r);
+#define polyx_basemul_montgomery KYBER_NAMESPACE(polyx_basemul_montgomery)
+void polyx_basemul_montgomery(polyx *r, const polyx *a, const polyx *b);
+#define polyx_tomont KYBER_NAMESPACE(polyx_tomont)
+void polyx_tomont(polyx *r);
+
+#define polyx_reduce KYBER_NAMESPACE(polyx_reduce)
+void polyx_reduce(polyx *r);
+
+#define polyx_add KYBER_NAMESPACE(polyx_add)
+void polyx_add(polyx *r, const polyx *a, const polyx *b);
+#define polyx_sub KYBER_NAMESPACE(polyx_sub)
+void polyx_sub(polyx *r, const polyx *a, const polyx *b);
+
+#define polyvecx_compress KYBER_NAMESPACE(polyvecx_compress)
+void polyvecx_compress(uint8_t *r[KYBER_LANES], const polyvecx *a);
+#define polyvecx_decompress KYBER_NAMESPACE(polyvecx_decompress)
+void polyvecx_decompress(polyvecx *r, const uint8_t *a[KYBER_LANES]);
+
+#define polyvecx_ntt KYBER_NAMESPACE(polyvecx_ntt)
+void polyvecx_ntt(polyvecx *r);
+#define polyvecx_invntt_tomont KYBER_NAMESPACE(polyvecx_invntt_tomont)
+void polyvecx_invntt_tomont(polyvecx *r);
+
+#define polyvecx_reduce KYBER_NAMESPACE(polyvecx_reduce)
+void polyvecx_reduce(polyvecx *r);
+
+#endif
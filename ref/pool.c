@@ -0,0 +1,547 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "params.h"
+#include "pool.h"
+#include "indcpa.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "symmetric.h"
+#include "verify.h"
+#include "randombytes.h"
+
+/* Iterations a helper polls for the next job before it sleeps, and a
+ * waiting caller polls before it yields the core */
+#ifndef KYBER_POOL_SPIN
+#define KYBER_POOL_SPIN 4096
+#endif
+
+/* A job is n independent tasks fn(arg, i), claimed one by one from next
+ * by the helpers and the submitting thread. It lives on the stack of the
+ * submitting thread, which does not return before every helper has
+ * stopped looking at it (pool->active). */
+typedef struct {
+  void (*fn)(void *arg, unsigned int i);
+  void *arg;
+  unsigned int n;
+  atomic_uint next;
+  atomic_uint done;
+} pool_job;
+
+struct kem_pool {
+  pthread_t *threads;
+  unsigned int nthreads;
+  pthread_mutex_t busy;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  atomic_uint gen;
+  atomic_uint active;
+  pool_job *_Atomic job;
+  atomic_int stop;
+};
+
+static void pool_work(pool_job *job)
+{
+  unsigned int i;
+
+  while((i = atomic_fetch_add(&job->next, 1)) < job->n) {
+    job->fn(job->arg, i);
+    atomic_fetch_add(&job->done, 1);
+  }
+}
+
+static void *pool_helper(void *arg)
+{
+  kem_pool *pool = arg;
+  unsigned int seen = 0, spin;
+  pool_job *job;
+
+  for(;;) {
+    for(spin=0;spin<KYBER_POOL_SPIN && atomic_load(&pool->gen) == seen;spin++)
+      ;
+    pthread_mutex_lock(&pool->lock);
+    while(atomic_load(&pool->gen) == seen && !atomic_load(&pool->stop))
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    if(atomic_load(&pool->stop))
+      return NULL;
+    seen = atomic_load(&pool->gen);
+
+    /* Announce before looking at the job, so that its owner waits */
+    atomic_fetch_add(&pool->active, 1);
+    job = atomic_load(&pool->job);
+    if(job)
+      pool_work(job);
+    atomic_fetch_sub(&pool->active, 1);
+  }
+}
+
+static void pool_submit(kem_pool *pool, pool_job *job)
+{
+  atomic_store(&job->next, 0);
+  atomic_store(&job->done, 0);
+  atomic_store(&pool->job, job);
+  if(pool->nthreads == 0)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  atomic_fetch_add(&pool->gen, 1);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void pool_join(kem_pool *pool, pool_job *job)
+{
+  unsigned int spin = 0;
+
+  pool_work(job);
+  while(atomic_load(&job->done) < job->n)
+    if(++spin > KYBER_POOL_SPIN)
+      sched_yield();
+  atomic_store(&pool->job, NULL);
+  while(atomic_load(&pool->active) > 0)
+    if(++spin > KYBER_POOL_SPIN)
+      sched_yield();
+}
+
+/*************************************************
+* Name:        kem_pool_new
+*
+* Description: Starts a pool of helper threads for the *_pool functions
+*
+* Arguments:   - unsigned int nhelpers: number of helper threads; with 0
+*                the calling thread does all work
+*
+* Returns the pool, or NULL if it could not be created
+**************************************************/
+kem_pool *kem_pool_new(unsigned int nhelpers)
+{
+  kem_pool *pool = calloc(1, sizeof(kem_pool));
+
+  if(!pool)
+    return NULL;
+  pool->threads = calloc(nhelpers ? nhelpers : 1, sizeof(pthread_t));
+  if(!pool->threads) {
+    free(pool);
+    return NULL;
+  }
+  pthread_mutex_init(&pool->busy, NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  atomic_init(&pool->gen, 0);
+  atomic_init(&pool->active, 0);
+  atomic_init(&pool->job, NULL);
+  atomic_init(&pool->stop, 0);
+
+  for(pool->nthreads=0;pool->nthreads<nhelpers;pool->nthreads++) {
+    if(pthread_create(&pool->threads[pool->nthreads], NULL, pool_helper, pool)) {
+      kem_pool_free(pool);
+      return NULL;
+    }
+  }
+
+  return pool;
+}
+
+/*************************************************
+* Name:        kem_pool_free
+*
+* Description: Stops the helper threads and frees the pool
+*
+* Arguments:   - kem_pool *pool: pointer to pool (may be NULL)
+**************************************************/
+void kem_pool_free(kem_pool *pool)
+{
+  unsigned int i;
+
+  if(!pool)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  atomic_store(&pool->stop, 1);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for(i=0;i<pool->nthreads;i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_mutex_destroy(&pool->busy);
+  free(pool->threads);
+  free(pool);
+}
+
+/* Independent parts of keypair and encryption. The tasks of the sampling
+ * stage are the K^2 matrix entries followed by the noise polynomials in
+ * nonce order, numbered from first; the tasks of the final stage are the
+ * rows of the matrix-vector product and, in encryption, v. */
+typedef struct {
+  polyvec a[KYBER_K];
+  polyvec s;
+  polyvec e;
+  polyvec t;
+  polyvec pkpv;
+  poly epp;
+  poly v;
+  poly k;
+  const uint8_t *seed;
+  const uint8_t *noiseseed;
+  unsigned int first;
+  /* Rejection key of a decapsulation */
+  uint8_t *rk;
+  const uint8_t *z;
+  const uint8_t *ct;
+} pool_ctx;
+
+static void keypair_task(void *arg, unsigned int i)
+{
+  pool_ctx *ctx = arg;
+
+  if(i < KYBER_K*KYBER_K) {
+    poly_uniform(&ctx->a[i/KYBER_K].vec[i%KYBER_K], ctx->seed, i%KYBER_K, i/KYBER_K);
+    return;
+  }
+
+  i -= KYBER_K*KYBER_K;
+  if(i < KYBER_K) {
+    poly_getnoise_eta1(&ctx->s.vec[i], ctx->noiseseed, i);
+    poly_ntt(&ctx->s.vec[i]);
+  } else {
+    poly_getnoise_eta1(&ctx->e.vec[i-KYBER_K], ctx->noiseseed, i);
+    poly_ntt(&ctx->e.vec[i-KYBER_K]);
+  }
+}
+
+static void keypair_row_task(void *arg, unsigned int i)
+{
+  pool_ctx *ctx = arg;
+
+  polyvec_basemul_acc_montgomery(&ctx->t.vec[i], &ctx->a[i], &ctx->s);
+  poly_tomont(&ctx->t.vec[i]);
+  poly_add(&ctx->t.vec[i], &ctx->t.vec[i], &ctx->e.vec[i]);
+  poly_reduce(&ctx->t.vec[i]);
+}
+
+static void enc_task(void *arg, unsigned int i)
+{
+  pool_ctx *ctx = arg;
+
+  i += ctx->first;
+  if(i < KYBER_K*KYBER_K) {
+    poly_uniform(&ctx->a[i/KYBER_K].vec[i%KYBER_K], ctx->seed, i/KYBER_K, i%KYBER_K);
+    return;
+  }
+
+  i -= KYBER_K*KYBER_K;
+  if(i < KYBER_K) {
+    poly_getnoise_eta1(&ctx->s.vec[i], ctx->noiseseed, i);
+    poly_ntt(&ctx->s.vec[i]);
+  } else if(i < 2*KYBER_K) {
+    poly_getnoise_eta2(&ctx->e.vec[i-KYBER_K], ctx->noiseseed, i);
+  } else {
+    poly_getnoise_eta2(&ctx->epp, ctx->noiseseed, i);
+  }
+}
+
+static void enc_row_task(void *arg, unsigned int i)
+{
+  pool_ctx *ctx = arg;
+
+  if(i < KYBER_K) {
+    polyvec_basemul_acc_montgomery(&ctx->t.vec[i], &ctx->a[i], &ctx->s);
+    poly_invntt_tomont(&ctx->t.vec[i]);
+    poly_add(&ctx->t.vec[i], &ctx->t.vec[i], &ctx->e.vec[i]);
+    poly_reduce(&ctx->t.vec[i]);
+  } else {
+    polyvec_basemul_acc_montgomery(&ctx->v, &ctx->pkpv, &ctx->s);
+    poly_invntt_tomont(&ctx->v);
+    poly_add(&ctx->v, &ctx->v, &ctx->epp);
+    poly_add(&ctx->v, &ctx->v, &ctx->k);
+    poly_reduce(&ctx->v);
+  }
+}
+
+/* Expansion of A^T, plus the rejection key of a decapsulation as the
+ * last task */
+static void dec_task(void *arg, unsigned int i)
+{
+  pool_ctx *ctx = arg;
+
+  if(i < KYBER_K*KYBER_K)
+    enc_task(arg, i);
+  else
+    rkprf(ctx->rk, ctx->z, ctx->ct);
+}
+
+/*************************************************
+* Name:        enc_start
+*
+* Description: Starts expanding A^T of a public key on the helpers, and
+*              with rk set the rejection key ctx->rk; the caller is free
+*              until enc_finish
+**************************************************/
+static void enc_start(kem_pool *pool,
+                      pool_job *job,
+                      pool_ctx *ctx,
+                      const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                      int rk)
+{
+  ctx->seed = pk+KYBER_POLYVECBYTES;
+  ctx->first = 0;
+  job->fn = rk ? dec_task : enc_task;
+  job->arg = ctx;
+  job->n = KYBER_K*KYBER_K + (rk ? 1 : 0);
+  pool_submit(pool, job);
+}
+
+/*************************************************
+* Name:        enc_finish
+*
+* Description: Joins the expansion of A^T, then samples the noise and
+*              computes the rows of the product on the helpers; same
+*              output as indcpa_enc(c, m, pk, coins)
+**************************************************/
+static void enc_finish(kem_pool *pool,
+                       pool_job *job,
+                       pool_ctx *ctx,
+                       uint8_t c[KYBER_INDCPA_BYTES],
+                       const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                       const uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
+                       const uint8_t coins[KYBER_SYMBYTES])
+{
+  pool_join(pool, job);
+
+  ctx->noiseseed = coins;
+  ctx->first = KYBER_K*KYBER_K;
+  job->fn = enc_task;
+  job->n = 2*KYBER_K+1;
+  pool_submit(pool, job);
+  polyvec_frombytes(&ctx->pkpv, pk);
+  poly_frommsg(&ctx->k, m);
+  pool_join(pool, job);
+
+  job->fn = enc_row_task;
+  job->n = KYBER_K+1;
+  pool_submit(pool, job);
+  pool_join(pool, job);
+
+  polyvec_compress(c, &ctx->t);
+  poly_compress(c+KYBER_POLYVECCOMPRESSEDBYTES, &ctx->v);
+}
+
+/*************************************************
+* Name:        crypto_kem_keypair_derand_pool
+*
+* Description: crypto_kem_keypair_derand with the matrix, the noise and
+*              the rows of the product computed in parallel on the pool
+*
+* Arguments:   - uint8_t *pk: pointer to output public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - uint8_t *sk: pointer to output private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with 2*KYBER_SYMBYTES random bytes)
+*              - kem_pool *pool: pointer to helper pool
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_keypair_derand_pool(uint8_t *pk,
+                                   uint8_t *sk,
+                                   const uint8_t *coins,
+                                   kem_pool *pool)
+{
+  uint8_t buf[2*KYBER_SYMBYTES];
+  pool_ctx ctx;
+  pool_job job;
+
+  memcpy(buf, coins, KYBER_SYMBYTES);
+  buf[KYBER_SYMBYTES] = KYBER_K;
+  hash_g(buf, buf, KYBER_SYMBYTES+1);
+
+  pthread_mutex_lock(&pool->busy);
+  ctx.seed = buf;
+  ctx.noiseseed = buf+KYBER_SYMBYTES;
+  job.fn = keypair_task;
+  job.arg = &ctx;
+  job.n = KYBER_K*KYBER_K+2*KYBER_K;
+  pool_submit(pool, &job);
+  pool_join(pool, &job);
+
+  // matrix-vector multiplication
+  job.fn = keypair_row_task;
+  job.n = KYBER_K;
+  pool_submit(pool, &job);
+  pool_join(pool, &job);
+  pthread_mutex_unlock(&pool->busy);
+
+  polyvec_tobytes(sk, &ctx.s);
+  polyvec_tobytes(pk, &ctx.t);
+  memcpy(pk+KYBER_POLYVECBYTES, buf, KYBER_SYMBYTES);
+
+  memcpy(sk+KYBER_INDCPA_SECRETKEYBYTES, pk, KYBER_PUBLICKEYBYTES);
+  hash_h(sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
+  /* Value z for pseudo-random output on reject */
+  memcpy(sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES, coins+KYBER_SYMBYTES, KYBER_SYMBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_keypair_pool
+*
+* Description: crypto_kem_keypair with the matrix and the noise sampled
+*              in parallel on the pool
+*
+* Arguments:   - uint8_t *pk: pointer to output public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - uint8_t *sk: pointer to output private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*              - kem_pool *pool: pointer to helper pool
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_keypair_pool(uint8_t *pk,
+                            uint8_t *sk,
+                            kem_pool *pool)
+{
+  uint8_t coins[2*KYBER_SYMBYTES];
+  randombytes(coins, 2*KYBER_SYMBYTES);
+  crypto_kem_keypair_derand_pool(pk, sk, coins, pool);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_derand_pool
+*
+* Description: crypto_kem_enc_derand with A^T expanded on the pool while
+*              the caller hashes, then the noise and the rows of the
+*              product computed in parallel
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+*              - kem_pool *pool: pointer to helper pool
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_derand_pool(uint8_t *ct,
+                               uint8_t *ss,
+                               const uint8_t *pk,
+                               const uint8_t *coins,
+                               kem_pool *pool)
+{
+  uint8_t buf[2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+  pool_ctx ctx;
+  pool_job job;
+
+  pthread_mutex_lock(&pool->busy);
+  enc_start(pool, &job, &ctx, pk, 0);
+
+  memcpy(buf, coins, KYBER_SYMBYTES);
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  hash_h(buf+KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  enc_finish(pool, &job, &ctx, ct, buf, pk, kr+KYBER_SYMBYTES);
+  pthread_mutex_unlock(&pool->busy);
+
+  memcpy(ss,kr,KYBER_SYMBYTES);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_pool
+*
+* Description: crypto_kem_enc with A^T expanded on the pool while the
+*              caller hashes, then the noise and the rows of the product
+*              computed in parallel
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - kem_pool *pool: pointer to helper pool
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_enc_pool(uint8_t *ct,
+                        uint8_t *ss,
+                        const uint8_t *pk,
+                        kem_pool *pool)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_derand_pool(ct, ss, pk, coins, pool);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_pool
+*
+* Description: crypto_kem_dec with A^T of the re-encryption and the
+*              rejection key computed on the pool while the caller
+*              decrypts, then the noise and the rows of the product of the
+*              re-encryption computed in parallel
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*              - kem_pool *pool: pointer to helper pool
+*
+* Returns 0.
+*
+* On failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_pool(uint8_t *ss,
+                        const uint8_t *ct,
+                        const uint8_t *sk,
+                        kem_pool *pool)
+{
+  int fail;
+  uint8_t buf[2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+  uint8_t cmp[KYBER_CIPHERTEXTBYTES];
+  const uint8_t *pk = sk+KYBER_INDCPA_SECRETKEYBYTES;
+  pool_ctx ctx;
+  pool_job job;
+
+  pthread_mutex_lock(&pool->busy);
+  ctx.rk = ss;
+  ctx.z = sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES;
+  ctx.ct = ct;
+  enc_start(pool, &job, &ctx, pk, 1);
+
+  indcpa_dec(buf, ct, sk);
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  memcpy(buf+KYBER_SYMBYTES, sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  enc_finish(pool, &job, &ctx, cmp, buf, pk, kr+KYBER_SYMBYTES);
+  pthread_mutex_unlock(&pool->busy);
+
+  /* Rejection key is in ss */
+  fail = verify(ct, cmp, KYBER_CIPHERTEXTBYTES);
+
+  /* Copy true key to return buffer if fail is false */
+  cmov(ss,kr,KYBER_SYMBYTES,!fail);
+
+  return 0;
+}
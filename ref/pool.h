@@ -0,0 +1,42 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+#include "params.h"
+
+/* Low-latency mode: a persistent pool of helper threads (POSIX threads)
+ * that takes the independent parts of one operation off the critical
+ * path. The entries of the matrix A, the noise polynomials and the rows of
+ * the matrix-vector product are computed by the helpers and the calling
+ * thread together; in decapsulation the matrix of the re-encryption and
+ * the rejection key are computed while the caller decrypts.
+ * Helpers spin briefly for the next operation before they sleep, so the
+ * pool is meant for otherwise idle cores; its latency gain has not been
+ * measured on a multi-core machine yet. Results are identical to those
+ * of the functions in kem.h. A pool serves one operation at a time;
+ * concurrent callers are serialized. */
+
+typedef struct kem_pool kem_pool;
+
+#define kem_pool_new KYBER_NAMESPACE(kem_pool_new)
+kem_pool *kem_pool_new(unsigned int nhelpers);
+
+#define kem_pool_free KYBER_NAMESPACE(kem_pool_free)
+void kem_pool_free(kem_pool *pool);
+
+#define crypto_kem_keypair_derand_pool KYBER_NAMESPACE(keypair_derand_pool)
+int crypto_kem_keypair_derand_pool(uint8_t *pk, uint8_t *sk, const uint8_t *coins, kem_pool *pool);
+
+#define crypto_kem_keypair_pool KYBER_NAMESPACE(keypair_pool)
+int crypto_kem_keypair_pool(uint8_t *pk, uint8_t *sk, kem_pool *pool);
+
+#define crypto_kem_enc_derand_pool KYBER_NAMESPACE(enc_derand_pool)
+int crypto_kem_enc_derand_pool(uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *coins, kem_pool *pool);
+
+#define crypto_kem_enc_pool KYBER_NAMESPACE(enc_pool)
+int crypto_kem_enc_pool(uint8_t *ct, uint8_t *ss, const uint8_t *pk, kem_pool *pool);
+
+#define crypto_kem_dec_pool KYBER_NAMESPACE(dec_pool)
+int crypto_kem_dec_pool(uint8_t *ss, const uint8_t *ct, const uint8_t *sk, kem_pool *pool);
+
+#endif
@@ -0,0 +1,266 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "params.h"
+#include "kem.h"
+#include "clockcache.h"
+#include "keystore.h"
+#include "lockstep.h"
+#include "seedkey.h"
+#include "randombytes.h"
+#include "verify.h"
+
+struct kem_skcache {
+  const keystore *ks;
+  clockcache *cache;
+};
+
+/*************************************************
+* Name:        crypto_kem_keypair_seed
+*
+* Description: Generates public key and seed-only private key
+*
+* Arguments:   - uint8_t *pk: pointer to output public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - uint8_t *seed: pointer to output key seed
+*                (an already allocated array of KYBER_SEEDKEYBYTES bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_keypair_seed(uint8_t *pk, uint8_t *seed)
+{
+  uint8_t sk[KYBER_SECRETKEYBYTES];
+
+  randombytes(seed, KYBER_SEEDKEYBYTES);
+  crypto_kem_keypair_derand(pk, sk, seed);
+  wipe(sk, sizeof(sk));
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_seed_expand
+*
+* Description: Regenerates the private key of a key seed
+*
+* Arguments:   - uint8_t *sk: pointer to output private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*              - const uint8_t *seed: pointer to input key seed
+*                (an already allocated array of KYBER_SEEDKEYBYTES bytes)
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_seed_expand(uint8_t *sk, const uint8_t *seed)
+{
+  uint8_t pk[KYBER_PUBLICKEYBYTES];
+
+  crypto_kem_keypair_derand(pk, sk, seed);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_seed_expand_batch
+*
+* Description: Regenerates the private keys of n key seeds; groups of
+*              keys go through the lockstep key generation. A padded
+*              group costs almost as much as a full one, so groups of
+*              fewer than 3/4 KYBER_LANES keys are expanded one by one.
+*
+* Arguments:   - uint8_t *sk: pointer to output private keys
+*                (an already allocated array of n*KYBER_SECRETKEYBYTES bytes)
+*              - const uint8_t *seeds: pointer to input key seeds
+*                (an already allocated array of n*KYBER_SEEDKEYBYTES bytes)
+*              - size_t n: number of keys
+*
+* Returns 0, or -1 if memory allocation failed
+**************************************************/
+int crypto_kem_seed_expand_batch(uint8_t *sk, const uint8_t *seeds, size_t n)
+{
+  size_t i, j, m;
+  uint8_t *pk = NULL;
+
+  for(i=0;i<n;i+=m) {
+    m = (n - i < KYBER_LANES) ? n - i : KYBER_LANES;
+    if(4*m >= 3*KYBER_LANES) {
+      /* Public keys of a lane group, off the stack */
+      if(!pk && !(pk = malloc(KYBER_LANES*KYBER_PUBLICKEYBYTES)))
+        return -1;
+      crypto_kem_keypair_derand_lockstep(pk, sk + i*KYBER_SECRETKEYBYTES,
+                                         seeds + i*KYBER_SEEDKEYBYTES, m);
+    }
+    else
+      for(j=i;j<i+m;j++)
+        crypto_kem_seed_expand(sk + j*KYBER_SECRETKEYBYTES, seeds + j*KYBER_SEEDKEYBYTES);
+  }
+  free(pk);
+  return 0;
+}
+
+/*************************************************
+* Name:        kem_skcache_new
+*
+* Description: Creates an empty cache of expanded keys for a key store
+*              (with private keys or key seeds)
+*
+* Arguments:   - const keystore *ks: pointer to open key store; must stay
+*                open while the cache is in use
+*              - size_t budget: memory budget in bytes; an entry takes
+*                somewhat more than KYBER_EXPANDEDSECRETKEYBYTES
+*
+* Returns the cache, or NULL if the budget does not hold one entry or
+* the cache could not be created
+**************************************************/
+kem_skcache *kem_skcache_new(const keystore *ks, size_t budget)
+{
+  kem_skcache *c;
+
+  c = malloc(sizeof(kem_skcache));
+  if(!c)
+    return NULL;
+  c->cache = clockcache_new(budget, sizeof(uint64_t), sizeof(kem_expanded_sk));
+  if(!c->cache) {
+    free(c);
+    return NULL;
+  }
+  c->ks = ks;
+
+  return c;
+}
+
+/*************************************************
+* Name:        kem_skcache_free
+*
+* Description: Wipes and frees a cache
+*
+* Arguments:   - kem_skcache *c: pointer to cache (may be NULL)
+**************************************************/
+void kem_skcache_free(kem_skcache *c)
+{
+  if(!c)
+    return;
+  clockcache_free(c->cache);
+  free(c);
+}
+
+/*************************************************
+* Name:        kem_skcache_get_stats
+*
+* Description: Reads the counters and fill level of a cache
+*
+* Arguments:   - kem_skcache *c: pointer to cache
+*              - kem_skcache_stats *stats: pointer to output statistics
+**************************************************/
+void kem_skcache_get_stats(kem_skcache *c, kem_skcache_stats *stats)
+{
+  clockcache_get_stats(c->cache, stats);
+}
+
+/*************************************************
+* Name:        kem_skcache_load
+*
+* Description: Expands the keys with the given ids into the cache ahead of
+*              use; seeds are expanded in batches. Keys that are already
+*              cached are skipped; beyond the capacity of the cache later
+*              keys evict earlier ones.
+*
+* Arguments:   - kem_skcache *c: pointer to cache
+*              - const uint64_t *ids: key ids
+*              - size_t n: number of ids
+*
+* Returns the number of ids found in the key store, or 0 if memory
+* allocation failed
+**************************************************/
+size_t kem_skcache_load(kem_skcache *c, const uint64_t *ids, size_t n)
+{
+  size_t i, j, m, found = 0;
+  const uint8_t *key;
+  uint64_t batch[KYBER_LANES];
+  /* A lane group of seeds and keys is too large for small thread stacks */
+  struct {
+    uint8_t seeds[KYBER_LANES][KYBER_SEEDKEYBYTES];
+    uint8_t sks[KYBER_LANES][KYBER_SECRETKEYBYTES];
+    kem_expanded_sk esk;
+  } *t;
+
+  t = malloc(sizeof(*t));
+  if(!t)
+    return 0;
+
+  for(i=0;i<n;) {
+    /* Gather up to KYBER_LANES seeds of keys not cached yet */
+    for(m=0;i<n && m<KYBER_LANES;i++) {
+      key = keystore_find(c->ks, ids[i]);
+      if(!key)
+        continue;
+      found++;
+      if(clockcache_contains(c->cache, clockcache_mix64(ids[i]), &ids[i]))
+        continue;
+      if(!c->ks->seeds) {
+        crypto_kem_sk_expand(&t->esk, key);
+        clockcache_put(c->cache, clockcache_mix64(ids[i]), &ids[i], &t->esk);
+        continue;
+      }
+      batch[m] = ids[i];
+      memcpy(t->seeds[m], key, KYBER_SEEDKEYBYTES);
+      m++;
+    }
+
+    if(crypto_kem_seed_expand_batch(t->sks[0], t->seeds[0], m)) {
+      found = 0;
+      break;
+    }
+    for(j=0;j<m;j++) {
+      crypto_kem_sk_expand(&t->esk, t->sks[j]);
+      clockcache_put(c->cache, clockcache_mix64(batch[j]), &batch[j], &t->esk);
+    }
+  }
+
+  wipe(t, sizeof(*t));
+  free(t);
+  return found;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_cached
+*
+* Description: Generates shared secret for given cipher text and the key
+*              with the given id, taking its expanded form from the cache
+*              and expanding it from the key store on a miss; same output
+*              as crypto_kem_dec_by_id
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *ct: pointer to input cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - kem_skcache *c: pointer to cache
+*              - uint64_t id: key id
+*
+* Returns 0, or -1 if there is no such key (ss is then untouched).
+*
+* On decapsulation failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_cached(uint8_t *ss, const uint8_t *ct, kem_skcache *c, uint64_t id)
+{
+  uint64_t h = clockcache_mix64(id);
+  const uint8_t *key;
+  uint8_t sk[KYBER_SECRETKEYBYTES];
+  kem_expanded_sk esk;
+
+  if(clockcache_get(c->cache, h, &id, &esk)) {
+    key = keystore_find(c->ks, id);
+    if(!key)
+      return -1;
+    if(c->ks->seeds) {
+      crypto_kem_seed_expand(sk, key);
+      crypto_kem_sk_expand(&esk, sk);
+      wipe(sk, sizeof(sk));
+    }
+    else
+      crypto_kem_sk_expand(&esk, key);
+    clockcache_put(c->cache, h, &id, &esk);
+  }
+
+  crypto_kem_dec_expanded(ss, ct, &esk);
+  wipe(&esk, sizeof(esk));
+  return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef SEEDKEY_H
+#define SEEDKEY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+#include "clockcache.h"
+#include "keystore.h"
+
+/* Seed-only private keys: a key pair is kept as the KYBER_SEEDKEYBYTES
+ * coins of crypto_kem_keypair_derand and regenerated when it is needed,
+ * 64 bytes per key instead of KYBER_SECRETKEYBYTES (see also
+ * keystore_create_seeds). Batches of seeds are expanded with the lockstep
+ * key generation of lockstep.h. Since regenerating a key costs a key
+ * generation, kem_skcache keeps a bounded number of the keys of a key
+ * store in expanded form (kem_expanded_sk) and evicts the least recently
+ * used one when its memory budget is used up (see clockcache.h). */
+
+#define crypto_kem_keypair_seed KYBER_NAMESPACE(keypair_seed)
+int crypto_kem_keypair_seed(uint8_t *pk, uint8_t *seed);
+
+#define crypto_kem_seed_expand KYBER_NAMESPACE(seed_expand)
+int crypto_kem_seed_expand(uint8_t *sk, const uint8_t *seed);
+
+#define crypto_kem_seed_expand_batch KYBER_NAMESPACE(seed_expand_batch)
+int crypto_kem_seed_expand_batch(uint8_t *sk, const uint8_t *seeds, size_t n);
+
+typedef struct kem_skcache kem_skcache;
+
+typedef clockcache_stats kem_skcache_stats;
+
+#define kem_skcache_new KYBER_NAMESPACE(kem_skcache_new)
+kem_skcache *kem_skcache_new(const keystore *ks, size_t budget);
+
+#define kem_skcache_free KYBER_NAMESPACE(kem_skcache_free)
+void kem_skcache_free(kem_skcache *c);
+
+#define kem_skcache_get_stats KYBER_NAMESPACE(kem_skcache_get_stats)
+void kem_skcache_get_stats(kem_skcache *c, kem_skcache_stats *stats);
+
+#define kem_skcache_load KYBER_NAMESPACE(kem_skcache_load)
+size_t kem_skcache_load(kem_skcache *c, const uint64_t *ids, size_t n);
+
+#define crypto_kem_dec_cached KYBER_NAMESPACE(dec_cached)
+int crypto_kem_dec_cached(uint8_t *ss, const uint8_t *ct, kem_skcache *c, uint64_t id);
+
+#endif
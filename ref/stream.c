@@ -0,0 +1,523 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "params.h"
+#include "stream.h"
+#include "indcpa.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "randombytes.h"
+#include "symmetric.h"
+#include "verify.h"
+
+#define UBYTES (KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K)
+
+/*************************************************
+* Name:        dec_u
+*
+* Description: Decompresses and transforms polynomial i of u and
+*              accumulates its product with polynomial i of the secret
+*              key, in the order of polyvec_basemul_acc_montgomery
+**************************************************/
+static void dec_u(kem_dec_stream *s, unsigned int i, const uint8_t a[UBYTES])
+{
+  poly u, t;
+
+  poly_decompress_du(&u, a);
+  poly_ntt(&u);
+  if(i == 0)
+    poly_basemul_montgomery(&s->mp, &s->skpv.vec[0], &u);
+  else {
+    poly_basemul_montgomery(&t, &s->skpv.vec[i], &u);
+    poly_add(&s->mp, &s->mp, &t);
+  }
+}
+
+/* Completes the decryption with v, as in indcpa_dec */
+static void dec_v(kem_dec_stream *s, const uint8_t a[KYBER_POLYCOMPRESSEDBYTES])
+{
+  poly v;
+
+  poly_reduce(&s->mp);
+  poly_invntt_tomont(&s->mp);
+
+  poly_decompress(&v, a);
+  poly_sub(&s->mp, &v, &s->mp);
+  poly_reduce(&s->mp);
+
+  poly_tomsg(s->m, &s->mp);
+}
+
+/*************************************************
+* Name:        reencrypt
+*
+* Description: Derives key and coins from the decrypted message and
+*              re-encrypts it, as in crypto_kem_dec
+**************************************************/
+static void reencrypt(uint8_t cmp[KYBER_CIPHERTEXTBYTES],
+                      uint8_t kr[2*KYBER_SYMBYTES],
+                      const kem_dec_stream *s)
+{
+  uint8_t buf[2*KYBER_SYMBYTES];
+  const uint8_t *pk = s->sk+KYBER_INDCPA_SECRETKEYBYTES;
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  memcpy(buf, s->m, KYBER_INDCPA_MSGBYTES);
+  memcpy(buf+KYBER_SYMBYTES, s->sk+KYBER_SECRETKEYBYTES-2*KYBER_SYMBYTES, KYBER_SYMBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  indcpa_enc(cmp, buf, pk, kr+KYBER_SYMBYTES);
+  wipe(buf, sizeof(buf));
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_init
+*
+* Description: Starts the incremental decapsulation of a cipher text
+*
+* Arguments:   - kem_dec_stream *s: pointer to output context
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes);
+*                must stay valid until crypto_kem_dec_final
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_kem_dec_init(kem_dec_stream *s, const uint8_t *sk)
+{
+  polyvec_frombytes(&s->skpv, sk);
+  rkprf_init(&s->rkprf, sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES);
+  s->sk = sk;
+  s->pos = 0;
+  s->fill = 0;
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_update
+*
+* Description: Feeds the next bytes of the cipher text. Polynomials that
+*              are complete are processed at once; only the start of an
+*              incomplete one is copied into the context.
+*
+* Arguments:   - kem_dec_stream *s: pointer to context
+*              - const uint8_t *in: pointer to input bytes
+*              - size_t inlen: number of bytes
+*
+* Returns 0, or -1 if the input exceeds KYBER_CIPHERTEXTBYTES in total
+* (the context is then unchanged)
+**************************************************/
+int crypto_kem_dec_update(kem_dec_stream *s, const uint8_t *in, size_t inlen)
+{
+  unsigned int i, part;
+  size_t n;
+  const uint8_t *a;
+
+  if(inlen > KYBER_CIPHERTEXTBYTES - s->pos)
+    return -1;
+  rkprf_absorb(&s->rkprf, in, inlen);
+
+  while(inlen > 0) {
+    /* Polynomial i of u, or v for i == KYBER_K */
+    i = s->pos / UBYTES;
+    part = (i < KYBER_K) ? UBYTES : KYBER_POLYCOMPRESSEDBYTES;
+
+    if(s->fill == 0 && inlen >= part) {
+      a = in;
+      n = part;
+    }
+    else {
+      n = (inlen < part - s->fill) ? inlen : part - s->fill;
+      memcpy(s->buf + s->fill, in, n);
+      s->fill += n;
+      a = (s->fill == part) ? s->buf : NULL;
+      if(a)
+        s->fill = 0;
+    }
+    s->pos += n;
+    in += n;
+    inlen -= n;
+
+    if(a && i < KYBER_K)
+      dec_u(s, i, a);
+    else if(a)
+      dec_v(s, a);
+  }
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_final
+*
+* Description: Completes the decapsulation once the whole cipher text was
+*              fed and wipes the context. The cipher text is not kept:
+*              the rejection PRF values J(z, c) of the fed bytes and
+*              J(z, c') of the re-encryption are compared instead, so the
+*              result depends only on the bytes fed to
+*              crypto_kem_dec_update.
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - kem_dec_stream *s: pointer to context
+*
+* Returns 0, or -1 if fewer than KYBER_CIPHERTEXTBYTES bytes were fed
+* (ss and the context are then untouched).
+*
+* On decapsulation failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_final(uint8_t *ss, kem_dec_stream *s)
+{
+  int fail;
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+  uint8_t cmp[KYBER_CIPHERTEXTBYTES];
+  uint8_t jcmp[KYBER_SSBYTES];
+  keccak_state t;
+
+  if(s->pos != KYBER_CIPHERTEXTBYTES)
+    return -1;
+
+  reencrypt(cmp, kr, s);
+
+  /* Rejection key J(z, c), compared with J(z, c') */
+  rkprf_squeeze(ss, &s->rkprf);
+  rkprf_init(&t, s->sk+KYBER_SECRETKEYBYTES-KYBER_SYMBYTES);
+  rkprf_final(jcmp, &t, cmp);
+  fail = verify(ss, jcmp, KYBER_SSBYTES);
+
+  /* Copy true key to return buffer if fail is false */
+  cmov(ss,kr,KYBER_SYMBYTES,!fail);
+
+  wipe(kr, sizeof(kr));
+  wipe(&t, sizeof(t));
+  wipe(s, sizeof(*s));
+  return 0;
+}
+
+/*************************************************
+* Name:        enc_stream
+*
+* Description: indcpa_enc with an unpacked public key, computing and
+*              emitting one polynomial of the cipher text at a time;
+*              returns the first nonzero value returned by the sink, or 0
+**************************************************/
+static int enc_stream(const uint8_t m[KYBER_INDCPA_MSGBYTES],
+                      const polyvec *pkpv,
+                      const uint8_t seed[KYBER_SYMBYTES],
+                      const uint8_t coins[KYBER_SYMBYTES],
+                      kem_enc_sink sink,
+                      void *arg)
+{
+  unsigned int i, j;
+  int ret;
+  uint8_t nonce = 0;
+  uint8_t out[UBYTES];
+  polyvec sp, at;
+  poly b, e, k;
+
+  for(i=0;i<KYBER_K;i++)
+    poly_getnoise_eta1(sp.vec+i, coins, nonce++);
+  polyvec_ntt(&sp);
+
+  /* Row i of A^T, then polynomial i of u */
+  for(i=0;i<KYBER_K;i++) {
+    for(j=0;j<KYBER_K;j++)
+      poly_uniform(&at.vec[j], seed, i, j);
+    polyvec_basemul_acc_montgomery(&b, &at, &sp);
+    poly_invntt_tomont(&b);
+    poly_getnoise_eta2(&e, coins, nonce++);
+    poly_add(&b, &b, &e);
+    poly_reduce(&b);
+    poly_compress_du(out, &b);
+    ret = sink(arg, out, UBYTES);
+    if(ret)
+      goto out;
+  }
+
+  polyvec_basemul_acc_montgomery(&b, pkpv, &sp);
+  poly_invntt_tomont(&b);
+  poly_getnoise_eta2(&e, coins, nonce++);
+  poly_frommsg(&k, m);
+  poly_add(&b, &b, &e);
+  poly_add(&b, &b, &k);
+  poly_reduce(&b);
+  poly_compress(out, &b);
+  ret = sink(arg, out, KYBER_POLYCOMPRESSEDBYTES);
+
+out:
+  wipe(&sp, sizeof(sp));
+  wipe(&e, sizeof(e));
+  wipe(&k, sizeof(k));
+  return ret;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_stream_derand
+*
+* Description: Generates cipher text and shared secret for given public
+*              key, passing the cipher text to the sink in pieces while
+*              it is computed; same output as crypto_kem_enc_derand
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+*              - kem_enc_sink sink: receiver of the cipher text pieces
+*              - void *arg: first argument of sink
+*
+* Returns 0, or the nonzero value of the sink that aborted the
+* encapsulation (ss is then untouched)
+**************************************************/
+int crypto_kem_enc_stream_derand(uint8_t *ss,
+                                 const uint8_t *pk,
+                                 const uint8_t *coins,
+                                 kem_enc_sink sink,
+                                 void *arg)
+{
+  int ret;
+  uint8_t buf[2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+  polyvec pkpv;
+
+  memcpy(buf, coins, KYBER_SYMBYTES);
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  hash_h(buf+KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  polyvec_frombytes(&pkpv, pk);
+  ret = enc_stream(buf, &pkpv, pk+KYBER_POLYVECBYTES, kr+KYBER_SYMBYTES, sink, arg);
+  if(!ret)
+    memcpy(ss,kr,KYBER_SYMBYTES);
+
+  wipe(buf, sizeof(buf));
+  wipe(kr, sizeof(kr));
+  return ret;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_stream
+*
+* Description: Generates cipher text and shared secret for given public
+*              key, passing the cipher text to the sink in pieces while
+*              it is computed
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const uint8_t *pk: pointer to input public key
+*                (an already allocated array of KYBER_PUBLICKEYBYTES bytes)
+*              - kem_enc_sink sink: receiver of the cipher text pieces
+*              - void *arg: first argument of sink
+*
+* Returns 0, or the nonzero value of the sink that aborted the
+* encapsulation (ss is then untouched)
+**************************************************/
+int crypto_kem_enc_stream(uint8_t *ss,
+                          const uint8_t *pk,
+                          kem_enc_sink sink,
+                          void *arg)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  return crypto_kem_enc_stream_derand(ss, pk, coins, sink, arg);
+}
+
+/* Sink writing the pieces one after the other */
+static int put(void *arg, const uint8_t *chunk, size_t len)
+{
+  uint8_t **p = arg;
+
+  memcpy(*p, chunk, len);
+  *p += len;
+  return 0;
+}
+
+/*************************************************
+* Name:        unpack_pk_iov
+*
+* Description: Unpacks a public key given as an iovec list and hashes it
+*              with H on the way. Only polynomials that are split across
+*              iovecs are copied.
+*
+* Arguments:   - polyvec *pkpv: pointer to output public-key polynomial vector
+*              - uint8_t *seed: pointer to output seed to generate matrix A
+*              - uint8_t *h: pointer to output H(pk) (KYBER_SYMBYTES bytes)
+*              - const struct iovec *iov: pointer to input iovec list
+*              - int iovcnt: number of iovecs
+*
+* Returns 0, or -1 if the iovecs do not add up to KYBER_PUBLICKEYBYTES
+**************************************************/
+static int unpack_pk_iov(polyvec *pkpv,
+                         uint8_t seed[KYBER_SYMBYTES],
+                         uint8_t h[KYBER_SYMBYTES],
+                         const struct iovec *iov,
+                         int iovcnt)
+{
+  int j;
+  unsigned int i, part, fill = 0;
+  size_t pos = 0, n, len;
+  const uint8_t *in, *a;
+  uint8_t buf[KYBER_POLYBYTES];
+  keccak_state state;
+
+  for(j=0;j<iovcnt;j++) {
+    if(iov[j].iov_len > KYBER_PUBLICKEYBYTES - pos)
+      return -1;
+    pos += iov[j].iov_len;
+  }
+  if(pos != KYBER_PUBLICKEYBYTES)
+    return -1;
+
+  hash_h_init(&state);
+  pos = 0;
+  for(j=0;j<iovcnt;j++) {
+    in = iov[j].iov_base;
+    len = iov[j].iov_len;
+    hash_h_absorb(&state, in, len);
+
+    while(len > 0) {
+      /* Polynomial i of t, or the seed for i == KYBER_K */
+      i = pos / KYBER_POLYBYTES;
+      part = (i < KYBER_K) ? KYBER_POLYBYTES : KYBER_SYMBYTES;
+
+      if(fill == 0 && len >= part) {
+        a = in;
+        n = part;
+      }
+      else {
+        n = (len < part - fill) ? len : part - fill;
+        memcpy(buf + fill, in, n);
+        fill += n;
+        a = (fill == part) ? buf : NULL;
+        if(a)
+          fill = 0;
+      }
+      pos += n;
+      in += n;
+      len -= n;
+
+      if(a && i < KYBER_K)
+        poly_frombytes(&pkpv->vec[i], a);
+      else if(a)
+        memcpy(seed, a, KYBER_SYMBYTES);
+    }
+  }
+
+  hash_h_final(h, &state);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_iov_derand
+*
+* Description: crypto_kem_enc_derand for a public key given as an iovec
+*              list, e.g. as it was received
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const struct iovec *pk: pointer to input public key pieces
+*                (KYBER_PUBLICKEYBYTES bytes in total)
+*              - int pkcnt: number of iovecs
+*              - const uint8_t *coins: pointer to input randomness
+*                (an already allocated array filled with KYBER_SYMBYTES random bytes)
+*
+* Returns 0, or -1 if the public key has the wrong length
+* (ct and ss are then untouched)
+**************************************************/
+int crypto_kem_enc_iov_derand(uint8_t *ct,
+                              uint8_t *ss,
+                              const struct iovec *pk,
+                              int pkcnt,
+                              const uint8_t *coins)
+{
+  uint8_t buf[2*KYBER_SYMBYTES];
+  /* Will contain key, coins */
+  uint8_t kr[2*KYBER_SYMBYTES];
+  uint8_t seed[KYBER_SYMBYTES];
+  polyvec pkpv;
+
+  /* Multitarget countermeasure for coins + contributory KEM */
+  if(unpack_pk_iov(&pkpv, seed, buf+KYBER_SYMBYTES, pk, pkcnt))
+    return -1;
+  memcpy(buf, coins, KYBER_SYMBYTES);
+  hash_g(kr, buf, 2*KYBER_SYMBYTES);
+
+  /* coins are in kr+KYBER_SYMBYTES */
+  enc_stream(buf, &pkpv, seed, kr+KYBER_SYMBYTES, put, &ct);
+  memcpy(ss,kr,KYBER_SYMBYTES);
+
+  wipe(buf, sizeof(buf));
+  wipe(kr, sizeof(kr));
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_kem_enc_iov
+*
+* Description: crypto_kem_enc for a public key given as an iovec list
+*
+* Arguments:   - uint8_t *ct: pointer to output cipher text
+*                (an already allocated array of KYBER_CIPHERTEXTBYTES bytes)
+*              - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const struct iovec *pk: pointer to input public key pieces
+*                (KYBER_PUBLICKEYBYTES bytes in total)
+*              - int pkcnt: number of iovecs
+*
+* Returns 0, or -1 if the public key has the wrong length
+**************************************************/
+int crypto_kem_enc_iov(uint8_t *ct,
+                       uint8_t *ss,
+                       const struct iovec *pk,
+                       int pkcnt)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  randombytes(coins, KYBER_SYMBYTES);
+  return crypto_kem_enc_iov_derand(ct, ss, pk, pkcnt, coins);
+}
+
+/*************************************************
+* Name:        crypto_kem_dec_iov
+*
+* Description: crypto_kem_dec for a cipher text given as an iovec list;
+*              feeds the iovecs to crypto_kem_dec_update in turn and
+*              finishes with crypto_kem_dec_final
+*
+* Arguments:   - uint8_t *ss: pointer to output shared secret
+*                (an already allocated array of KYBER_SSBYTES bytes)
+*              - const struct iovec *ct: pointer to input cipher text pieces
+*                (KYBER_CIPHERTEXTBYTES bytes in total)
+*              - int ctcnt: number of iovecs
+*              - const uint8_t *sk: pointer to input private key
+*                (an already allocated array of KYBER_SECRETKEYBYTES bytes)
+*
+* Returns 0, or -1 if the cipher text has the wrong length
+* (ss is then untouched).
+*
+* On decapsulation failure, ss will contain a pseudo-random value.
+**************************************************/
+int crypto_kem_dec_iov(uint8_t *ss,
+                       const struct iovec *ct,
+                       int ctcnt,
+                       const uint8_t *sk)
+{
+  int i, ret = 0;
+  kem_dec_stream s;
+
+  crypto_kem_dec_init(&s, sk);
+  for(i=0;i<ctcnt && !ret;i++)
+    ret = crypto_kem_dec_update(&s, ct[i].iov_base, ct[i].iov_len);
+  if(!ret)
+    ret = crypto_kem_dec_final(ss, &s);
+  if(ret)
+    wipe(&s, sizeof(s));
+  return ret;
+}
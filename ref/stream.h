@@ -0,0 +1,75 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include "params.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "fips202.h"
+
+/* Incremental decapsulation of a cipher text that arrives in pieces:
+ * crypto_kem_dec_update takes the bytes as they come, decompresses and
+ * transforms each polynomial of u as soon as it is complete and
+ * accumulates its product with the secret key, and absorbs everything
+ * into the rejection PRF; the message is decrypted when the last byte
+ * arrives. crypto_kem_dec_final only re-encrypts. The cipher text is not
+ * kept: instead of the cipher texts themselves, the rejection PRF values
+ * J(z, c) and J(z, c') of the fed and the re-encrypted cipher text are
+ * compared, which only differ from the byte comparison on a SHAKE256
+ * collision. Everything depends on the fed bytes alone, so the caller may
+ * reuse its receive buffers at once. The shared secret is that of
+ * crypto_kem_dec. */
+typedef struct {
+  polyvec skpv;
+  poly mp;
+  keccak_state rkprf;
+  const uint8_t *sk;
+  size_t pos;
+  unsigned int fill;
+  uint8_t buf[KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K];
+  uint8_t m[KYBER_INDCPA_MSGBYTES];
+} kem_dec_stream;
+
+#define crypto_kem_dec_init KYBER_NAMESPACE(dec_init)
+int crypto_kem_dec_init(kem_dec_stream *s, const uint8_t *sk);
+
+#define crypto_kem_dec_update KYBER_NAMESPACE(dec_update)
+int crypto_kem_dec_update(kem_dec_stream *s, const uint8_t *in, size_t inlen);
+
+#define crypto_kem_dec_final KYBER_NAMESPACE(dec_final)
+int crypto_kem_dec_final(uint8_t *ss, kem_dec_stream *s);
+
+/* Encapsulation that hands the cipher text out while computing it: the
+ * sink receives each compressed polynomial of u (KYBER_POLYVECCOMPRESSEDBYTES
+ * / KYBER_K bytes) as soon as its row of the matrix-vector product is
+ * done, and v (KYBER_POLYCOMPRESSEDBYTES bytes) last, so that sending can
+ * start before the rest is computed. The matrix is sampled row by row on
+ * the way. Cipher text and shared secret are those of crypto_kem_enc.
+ * A nonzero return value of the sink aborts the encapsulation. */
+typedef int (*kem_enc_sink)(void *arg, const uint8_t *chunk, size_t len);
+
+#define crypto_kem_enc_stream_derand KYBER_NAMESPACE(enc_stream_derand)
+int crypto_kem_enc_stream_derand(uint8_t *ss, const uint8_t *pk, const uint8_t *coins, kem_enc_sink sink, void *arg);
+
+#define crypto_kem_enc_stream KYBER_NAMESPACE(enc_stream)
+int crypto_kem_enc_stream(uint8_t *ss, const uint8_t *pk, kem_enc_sink sink, void *arg);
+
+/* Scatter-gather variants for keys and cipher texts that arrive split
+ * across several receive buffers: public key and cipher text are read
+ * from the iovec lists in place, without first copying them into one
+ * array. H(pk) and the rejection PRF absorb the pieces incrementally and
+ * only a polynomial that straddles two iovecs is copied. Results are
+ * those of crypto_kem_enc and crypto_kem_dec; crypto_kem_dec_iov is
+ * crypto_kem_dec_init, _update and _final over the list. */
+#define crypto_kem_enc_iov_derand KYBER_NAMESPACE(enc_iov_derand)
+int crypto_kem_enc_iov_derand(uint8_t *ct, uint8_t *ss, const struct iovec *pk, int pkcnt, const uint8_t *coins);
+
+#define crypto_kem_enc_iov KYBER_NAMESPACE(enc_iov)
+int crypto_kem_enc_iov(uint8_t *ct, uint8_t *ss, const struct iovec *pk, int pkcnt);
+
+#define crypto_kem_dec_iov KYBER_NAMESPACE(dec_iov)
+int crypto_kem_dec_iov(uint8_t *ss, const struct iovec *ct, int ctcnt, const uint8_t *sk);
+
+#endif
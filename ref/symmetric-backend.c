@@ -0,0 +1,131 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "params.h"
+#include "symmetric.h"
+#include "fips202.h"
+#ifdef KYBER_SYMMETRIC_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+/* Run-time selectable providers of the one-shot symmetric primitives.
+ *
+ * Every backend computes exactly the FIPS-202 functions of the portable
+ * one, so they can be switched at any time without changing results. The
+ * XOF for the matrix, the keyed state of the rejection PRF and H over
+ * input in pieces are used incrementally and always use the portable
+ * sponge (OpenSSL only gained incremental squeezing in 3.3). */
+
+static const symmetric_backend backend_portable = {
+  "portable",
+  sha3_256,
+  sha3_512,
+  kyber_shake256_prf,
+  kyber_shake256_rkprf,
+};
+
+#ifdef KYBER_SYMMETRIC_OPENSSL
+/* Hash of in0||in1; aborts if OpenSSL fails, as randombytes does */
+static void openssl_digest(const EVP_MD *md,
+                           uint8_t *out,
+                           size_t outlen,
+                           const uint8_t *in0,
+                           size_t in0len,
+                           const uint8_t *in1,
+                           size_t in1len)
+{
+  int ok;
+  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+
+  ok = ctx != NULL
+    && EVP_DigestInit_ex(ctx, md, NULL)
+    && EVP_DigestUpdate(ctx, in0, in0len)
+    && (in1len == 0 || EVP_DigestUpdate(ctx, in1, in1len));
+  if(ok && EVP_MD_get_flags(md) & EVP_MD_FLAG_XOF)
+    ok = EVP_DigestFinalXOF(ctx, out, outlen);
+  else if(ok)
+    ok = EVP_DigestFinal_ex(ctx, out, NULL);
+  EVP_MD_CTX_free(ctx);
+  if(!ok)
+    abort();
+}
+
+static void openssl_hash_h(uint8_t out[32], const uint8_t *in, size_t inlen)
+{
+  openssl_digest(EVP_sha3_256(), out, 32, in, inlen, NULL, 0);
+}
+
+static void openssl_hash_g(uint8_t out[64], const uint8_t *in, size_t inlen)
+{
+  openssl_digest(EVP_sha3_512(), out, 64, in, inlen, NULL, 0);
+}
+
+static void openssl_prf(uint8_t *out, size_t outlen, const uint8_t key[KYBER_SYMBYTES], uint8_t nonce)
+{
+  openssl_digest(EVP_shake256(), out, outlen, key, KYBER_SYMBYTES, &nonce, 1);
+}
+
+static void openssl_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SYMBYTES], const uint8_t input[KYBER_CIPHERTEXTBYTES])
+{
+  openssl_digest(EVP_shake256(), out, KYBER_SSBYTES, key, KYBER_SYMBYTES, input, KYBER_CIPHERTEXTBYTES);
+}
+
+static const symmetric_backend backend_openssl = {
+  "openssl",
+  openssl_hash_h,
+  openssl_hash_g,
+  openssl_prf,
+  openssl_rkprf,
+};
+#endif
+
+static const symmetric_backend *const backends[] = {
+  &backend_portable,
+#ifdef KYBER_SYMMETRIC_OPENSSL
+  &backend_openssl,
+#endif
+};
+
+const symmetric_backend *symmetric_backend_current = &backend_portable;
+
+/*************************************************
+* Name:        symmetric_backend_get
+*
+* Description: Enumerates the backends compiled in; the first one is the
+*              portable default
+*
+* Arguments:   - size_t i: index of the backend
+*
+* Returns pointer to the backend, or NULL if i is out of range
+**************************************************/
+const symmetric_backend *symmetric_backend_get(size_t i)
+{
+  if(i >= sizeof(backends)/sizeof(backends[0]))
+    return NULL;
+  return backends[i];
+}
+
+/*************************************************
+* Name:        symmetric_backend_select
+*
+* Description: Makes a backend the current one for all later calls. Not
+*              synchronized; select before other threads use the KEM.
+*
+* Arguments:   - const char *name: name of the backend, e.g. "portable"
+*
+* Returns 0 on success, -1 if no backend of that name is compiled in
+**************************************************/
+int symmetric_backend_select(const char *name)
+{
+  size_t i;
+  const symmetric_backend *b;
+
+  for(i = 0; (b = symmetric_backend_get(i)) != NULL; i++) {
+    if(strcmp(b->name, name) == 0) {
+      symmetric_backend_current = b;
+      return 0;
+    }
+  }
+  return -1;
+}
@@ -51,23 +51,97 @@ void kyber_shake256_prf(uint8_t *out, size_t outlen, const uint8_t key[KYBER_SYM
 }
 
 /*************************************************
-* Name:        kyber_shake256_prf
+* Name:        kyber_shake256_rkprf_init
 *
-* Description: Usage of SHAKE256 as a PRF, concatenates secret and public input
-*              and then generates outlen bytes of SHAKE256 output
+* Description: Absorbs the key of the rejection PRF into a fresh SHAKE256
+*              state, to be reused for many inputs with
+*              kyber_shake256_rkprf_final
 *
-* Arguments:   - uint8_t *out: pointer to output
-*              - size_t outlen: number of requested output bytes
+* Arguments:   - keccak_state *s: pointer to output Keccak state
 *              - const uint8_t *key: pointer to the key (of length KYBER_SYMBYTES)
-*              - uint8_t nonce: single-byte nonce (public PRF input)
 **************************************************/
-void kyber_shake256_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SYMBYTES], const uint8_t input[KYBER_CIPHERTEXTBYTES])
+void kyber_shake256_rkprf_init(keccak_state *s, const uint8_t key[KYBER_SYMBYTES])
 {
-  keccak_state s;
+  shake256_init(s);
+  shake256_absorb(s, key, KYBER_SYMBYTES);
+}
+
+/*************************************************
+* Name:        kyber_shake256_rkprf_final
+*
+* Description: Finishes the rejection PRF on a copy of a keyed state
+*              from kyber_shake256_rkprf_init
+*
+* Arguments:   - uint8_t *out: pointer to output (of length KYBER_SSBYTES)
+*              - const keccak_state *init: pointer to keyed Keccak state (not modified)
+*              - const uint8_t *input: pointer to the input (of length KYBER_CIPHERTEXTBYTES)
+**************************************************/
+void kyber_shake256_rkprf_final(uint8_t out[KYBER_SSBYTES], const keccak_state *init, const uint8_t input[KYBER_CIPHERTEXTBYTES])
+{
+  keccak_state s = *init;
 
-  shake256_init(&s);
-  shake256_absorb(&s, key, KYBER_SYMBYTES);
   shake256_absorb(&s, input, KYBER_CIPHERTEXTBYTES);
   shake256_finalize(&s);
   shake256_squeeze(out, KYBER_SSBYTES, &s);
 }
+
+/*************************************************
+* Name:        kyber_shake256_rkprf
+*
+* Description: Usage of SHAKE256 as the rejection PRF, concatenates the
+*              key and the ciphertext and generates KYBER_SSBYTES of output
+*
+* Arguments:   - uint8_t *out: pointer to output (of length KYBER_SSBYTES)
+*              - const uint8_t *key: pointer to the key (of length KYBER_SYMBYTES)
+*              - const uint8_t *input: pointer to the input (of length KYBER_CIPHERTEXTBYTES)
+**************************************************/
+void kyber_shake256_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SYMBYTES], const uint8_t input[KYBER_CIPHERTEXTBYTES])
+{
+  keccak_state s;
+
+  kyber_shake256_rkprf_init(&s, key);
+  kyber_shake256_rkprf_final(out, &s, input);
+}
+
+#ifdef rkprf_x4
+/*************************************************
+* Name:        kyber_shake256_rkprf_x4
+*
+* Description: Four independent evaluations of kyber_shake256_rkprf with
+*              4-way SHAKE256
+*
+* Arguments:   - uint8_t *out0, ..., *out3: pointers to outputs
+*                (of length KYBER_SSBYTES)
+*              - const uint8_t *key0, ..., *key3: pointers to the keys
+*                (of length KYBER_SYMBYTES)
+*              - const uint8_t *input0, ..., *input3: pointers to the inputs
+*                (of length KYBER_CIPHERTEXTBYTES)
+**************************************************/
+void kyber_shake256_rkprf_x4(uint8_t *out0,
+                             uint8_t *out1,
+                             uint8_t *out2,
+                             uint8_t *out3,
+                             const uint8_t *key0,
+                             const uint8_t *key1,
+                             const uint8_t *key2,
+                             const uint8_t *key3,
+                             const uint8_t *input0,
+                             const uint8_t *input1,
+                             const uint8_t *input2,
+                             const uint8_t *input3)
+{
+  uint8_t buf[4][KYBER_SYMBYTES+KYBER_CIPHERTEXTBYTES];
+
+  memcpy(buf[0], key0, KYBER_SYMBYTES);
+  memcpy(buf[1], key1, KYBER_SYMBYTES);
+  memcpy(buf[2], key2, KYBER_SYMBYTES);
+  memcpy(buf[3], key3, KYBER_SYMBYTES);
+  memcpy(buf[0]+KYBER_SYMBYTES, input0, KYBER_CIPHERTEXTBYTES);
+  memcpy(buf[1]+KYBER_SYMBYTES, input1, KYBER_CIPHERTEXTBYTES);
+  memcpy(buf[2]+KYBER_SYMBYTES, input2, KYBER_CIPHERTEXTBYTES);
+  memcpy(buf[3]+KYBER_SYMBYTES, input3, KYBER_CIPHERTEXTBYTES);
+
+  shake256x4(out0, out1, out2, out3, KYBER_SSBYTES,
+             buf[0], buf[1], buf[2], buf[3], sizeof(buf[0]));
+}
+#endif
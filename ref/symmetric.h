@@ -21,13 +21,51 @@ void kyber_shake256_prf(uint8_t *out, size_t outlen, const uint8_t key[KYBER_SYM
 #define kyber_shake256_rkprf KYBER_NAMESPACE(kyber_shake256_rkprf)
 void kyber_shake256_rkprf(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SYMBYTES], const uint8_t input[KYBER_CIPHERTEXTBYTES]);
 
+#define kyber_shake256_rkprf_init KYBER_NAMESPACE(kyber_shake256_rkprf_init)
+void kyber_shake256_rkprf_init(keccak_state *s, const uint8_t key[KYBER_SYMBYTES]);
+
+#define kyber_shake256_rkprf_final KYBER_NAMESPACE(kyber_shake256_rkprf_final)
+void kyber_shake256_rkprf_final(uint8_t out[KYBER_SSBYTES], const keccak_state *init, const uint8_t input[KYBER_CIPHERTEXTBYTES]);
+
+/* Provider of the one-shot primitives, selectable at run time (see
+ * symmetric-backend.c) */
+typedef struct {
+  const char *name;
+  void (*hash_h)(uint8_t out[32], const uint8_t *in, size_t inlen);
+  void (*hash_g)(uint8_t out[64], const uint8_t *in, size_t inlen);
+  void (*prf)(uint8_t *out, size_t outlen, const uint8_t key[KYBER_SYMBYTES], uint8_t nonce);
+  void (*rkprf)(uint8_t out[KYBER_SSBYTES], const uint8_t key[KYBER_SYMBYTES], const uint8_t input[KYBER_CIPHERTEXTBYTES]);
+} symmetric_backend;
+
+#define symmetric_backend_current KYBER_NAMESPACE(symmetric_backend_current)
+extern const symmetric_backend *symmetric_backend_current;
+
+#define symmetric_backend_get KYBER_NAMESPACE(symmetric_backend_get)
+const symmetric_backend *symmetric_backend_get(size_t i);
+
+#define symmetric_backend_select KYBER_NAMESPACE(symmetric_backend_select)
+int symmetric_backend_select(const char *name);
+
 #define XOF_BLOCKBYTES SHAKE128_RATE
 
-#define hash_h(OUT, IN, INBYTES) sha3_256(OUT, IN, INBYTES)
-#define hash_g(OUT, IN, INBYTES) sha3_512(OUT, IN, INBYTES)
+#define hash_h(OUT, IN, INBYTES) symmetric_backend_current->hash_h(OUT, IN, INBYTES)
+#define hash_g(OUT, IN, INBYTES) symmetric_backend_current->hash_g(OUT, IN, INBYTES)
+/* Incremental H for input in pieces; always the portable sponge */
+#define hash_h_init(STATE) sha3_256_init(STATE)
+#define hash_h_absorb(STATE, IN, INBYTES) sha3_256_absorb(STATE, IN, INBYTES)
+#define hash_h_final(OUT, STATE) sha3_256_finalize(OUT, STATE)
 #define xof_absorb(STATE, SEED, X, Y) kyber_shake128_absorb(STATE, SEED, X, Y)
 #define xof_squeezeblocks(OUT, OUTBLOCKS, STATE) shake128_squeezeblocks(OUT, OUTBLOCKS, STATE)
-#define prf(OUT, OUTBYTES, KEY, NONCE) kyber_shake256_prf(OUT, OUTBYTES, KEY, NONCE)
-#define rkprf(OUT, KEY, INPUT) kyber_shake256_rkprf(OUT, KEY, INPUT)
+#define prf(OUT, OUTBYTES, KEY, NONCE) symmetric_backend_current->prf(OUT, OUTBYTES, KEY, NONCE)
+#define rkprf(OUT, KEY, INPUT) symmetric_backend_current->rkprf(OUT, KEY, INPUT)
+#define rkprf_init(STATE, KEY) kyber_shake256_rkprf_init(STATE, KEY)
+#define rkprf_final(OUT, STATE, INPUT) kyber_shake256_rkprf_final(OUT, STATE, INPUT)
+/* Incremental input to a keyed state, then output */
+#define rkprf_absorb(STATE, IN, INBYTES) shake256_absorb(STATE, IN, INBYTES)
+#define rkprf_squeeze(OUT, STATE) (shake256_finalize(STATE), shake256_squeeze(OUT, KYBER_SSBYTES, STATE))
+
+/* Group size of crypto_kem_dec_batch. Without multi-lane Keccak, grouping
+ * stages in portable C measured no faster than one by one. */
+#define KYBER_DEC_BATCH 1
 
 #endif /* SYMMETRIC_H */
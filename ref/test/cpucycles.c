@@ -8,9 +8,9 @@ uint64_t cpucycles_overhead(void) {
   unsigned int i;
 
   for(i=0;i<100000;i++) {
-    t0 = cpucycles();
+    t0 = cpucycles_start();
     __asm__ volatile ("");
-    t1 = cpucycles();
+    t1 = cpucycles_stop();
     if(t1 - t0 < overhead)
       overhead = t1 - t0;
   }
@@ -3,29 +3,91 @@
 
 #include <stdint.h>
 
+#if defined(__x86_64__)
+
+/* The lfence instructions keep the counter read from being reordered with
+ * the code being measured; without them out-of-order execution skews short
+ * measurements. The speed tests bracket each measured region with
+ * cpucycles_start() and cpucycles_stop(); cpucycles() is fenced on both
+ * sides for plain back-to-back reads. */
+
 #ifdef USE_RDPMC  /* Needs echo 2 > /sys/devices/cpu/rdpmc */
 
 static inline uint64_t cpucycles(void) {
   const uint32_t ecx = (1U << 30) + 1;
   uint64_t result;
 
-  __asm__ volatile ("rdpmc; shlq $32,%%rdx; orq %%rdx,%%rax"
-    : "=a" (result) : "c" (ecx) : "rdx");
+  __asm__ volatile ("lfence; rdpmc; lfence; shlq $32,%%rdx; orq %%rdx,%%rax"
+    : "=a" (result) : "c" (ecx) : "rdx", "memory");
 
   return result;
 }
 
+static inline uint64_t cpucycles_start(void) {
+  return cpucycles();
+}
+
+static inline uint64_t cpucycles_stop(void) {
+  return cpucycles();
+}
+
 #else
 
 static inline uint64_t cpucycles(void) {
   uint64_t result;
 
-  __asm__ volatile ("rdtsc; shlq $32,%%rdx; orq %%rdx,%%rax"
-    : "=a" (result) : : "%rdx");
+  __asm__ volatile ("lfence; rdtsc; lfence; shlq $32,%%rdx; orq %%rdx,%%rax"
+    : "=a" (result) : : "%rdx", "memory");
 
   return result;
 }
 
+/* Start of a measured region: earlier code has completed and the region
+ * cannot begin before the counter is read */
+static inline uint64_t cpucycles_start(void) {
+  return cpucycles();
+}
+
+/* End of a measured region: rdtscp waits for the region to complete, the
+ * trailing lfence keeps later code from starting early */
+static inline uint64_t cpucycles_stop(void) {
+  uint64_t result;
+
+  __asm__ volatile ("rdtscp; lfence; shlq $32,%%rdx; orq %%rdx,%%rax"
+    : "=a" (result) : : "%rcx", "%rdx", "memory");
+
+  return result;
+}
+
+#endif
+
+#else
+
+/* No serialized user-space cycle counter (e.g. arm64); count nanoseconds of
+ * the raw monotonic clock instead */
+#include <time.h>
+
+#ifdef CLOCK_MONOTONIC_RAW
+#define CPUCYCLES_CLOCK CLOCK_MONOTONIC_RAW
+#else
+#define CPUCYCLES_CLOCK CLOCK_MONOTONIC
+#endif
+
+static inline uint64_t cpucycles(void) {
+  struct timespec ts;
+
+  clock_gettime(CPUCYCLES_CLOCK, &ts);
+  return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t cpucycles_start(void) {
+  return cpucycles();
+}
+
+static inline uint64_t cpucycles_stop(void) {
+  return cpucycles();
+}
+
 #endif
 
 uint64_t cpucycles_overhead(void);
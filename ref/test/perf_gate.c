@@ -0,0 +1,339 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/utsname.h>
+#include "perf_gate.h"
+
+/* Performance regression gate for test_speed.
+ *
+ * Every measured primitive registers its cycle samples with perf_gate_add().
+ * perf_gate_save() stores them as a JSON baseline together with the
+ * implementation and host they were taken on; perf_gate_compare() reads a
+ * baseline and tests every primitive for a slowdown with a one-sided
+ * Mann-Whitney U test. A primitive regresses if the new samples are
+ * significantly larger (p < alpha) and the median grew by more than the
+ * threshold, so that noise and tiny but significant shifts do not fail the
+ * gate. */
+
+#define MAXENTRIES 64
+
+struct entry {
+  char name[64];
+  uint64_t *t;
+  size_t tlen;
+};
+
+static struct entry entries[MAXENTRIES];
+static size_t nentries;
+
+static int cmp_uint64(const void *a, const void *b) {
+  if(*(const uint64_t *)a < *(const uint64_t *)b) return -1;
+  if(*(const uint64_t *)a > *(const uint64_t *)b) return 1;
+  return 0;
+}
+
+static double median(const uint64_t *t, size_t tlen) {
+  if(tlen%2) return (double)t[tlen/2];
+  else return ((double)t[tlen/2-1] + (double)t[tlen/2])/2;
+}
+
+static void set_name(struct entry *e, const char *name, size_t len) {
+  if(len >= sizeof(e->name))
+    len = sizeof(e->name) - 1;
+  memcpy(e->name, name, len);
+  e->name[len] = '\0';
+}
+
+/*************************************************
+* Name:        perf_gate_add
+*
+* Description: Registers the cycle samples of one primitive. The samples are
+*              copied and sorted; t itself is left unchanged and need not
+*              be in any order.
+*
+* Arguments:   - const char *name: name of the primitive
+*              - const uint64_t *t: per-run cycle counts
+*              - size_t tlen: number of samples
+**************************************************/
+void perf_gate_add(const char *name, const uint64_t *t, size_t tlen) {
+  struct entry *e;
+
+  if(nentries == MAXENTRIES || tlen == 0)
+    return;
+
+  e = &entries[nentries];
+  e->t = malloc(tlen*sizeof(uint64_t));
+  if(!e->t)
+    return;
+  memcpy(e->t, t, tlen*sizeof(uint64_t));
+  qsort(e->t, tlen, sizeof(uint64_t), cmp_uint64);
+  e->tlen = tlen;
+  set_name(e, name, strlen(name));
+  nentries++;
+}
+
+/* Identifies the machine a baseline was taken on; quotes and backslashes
+ * are dropped so that the string can be stored verbatim in JSON */
+static void host_id(char *out, size_t outlen) {
+  char line[256], model[128] = "unknown cpu", *p;
+  struct utsname u;
+  FILE *f;
+  size_t i;
+
+  f = fopen("/proc/cpuinfo", "r");
+  if(f) {
+    while(fgets(line, sizeof(line), f)) {
+      if(strncmp(line, "model name", 10) == 0 && (p = strchr(line, ':'))) {
+        p += strspn(p + 1, " \t") + 1;
+        p[strcspn(p, "\r\n")] = '\0';
+        snprintf(model, sizeof(model), "%.*s", (int)sizeof(model) - 1, p);
+        break;
+      }
+    }
+    fclose(f);
+  }
+
+  if(uname(&u) == 0)
+    snprintf(out, outlen, "%s %s %s, %s", u.sysname, u.nodename, u.machine, model);
+  else
+    snprintf(out, outlen, "%s", model);
+
+  for(i = 0; out[i]; i++)
+    if(out[i] == '"' || out[i] == '\\')
+      out[i] = '_';
+}
+
+/*************************************************
+* Name:        perf_gate_save
+*
+* Description: Writes all registered samples as a JSON baseline.
+*
+* Arguments:   - const char *path: output file
+*              - const char *impl: implementation the samples belong to
+*
+* Returns 0 on success, -1 on error
+**************************************************/
+int perf_gate_save(const char *path, const char *impl) {
+  size_t i, j;
+  char host[512];
+  FILE *f;
+
+  f = fopen(path, "w");
+  if(!f) {
+    fprintf(stderr, "ERROR: cannot write baseline %s\n", path);
+    return -1;
+  }
+
+  host_id(host, sizeof(host));
+  fprintf(f, "{\n  \"impl\": \"%s\",\n  \"host\": \"%s\",\n  \"results\": {\n", impl, host);
+  for(i = 0; i < nentries; i++) {
+    fprintf(f, "    \"%s\": [", entries[i].name);
+    for(j = 0; j < entries[i].tlen; j++)
+      fprintf(f, "%s%llu", j ? "," : "", (unsigned long long)entries[i].t[j]);
+    fprintf(f, "]%s\n", (i + 1 < nentries) ? "," : "");
+  }
+  fprintf(f, "  }\n}\n");
+
+  if(fclose(f)) {
+    fprintf(stderr, "ERROR: cannot write baseline %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+static char *read_file(const char *path) {
+  char *buf;
+  long len;
+  FILE *f = fopen(path, "rb");
+
+  if(!f)
+    return NULL;
+  if(fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) {
+    fclose(f);
+    return NULL;
+  }
+  buf = malloc((size_t)len + 1);
+  if(buf && fread(buf, 1, (size_t)len, f) != (size_t)len) {
+    free(buf);
+    buf = NULL;
+  }
+  if(buf)
+    buf[len] = '\0';
+  fclose(f);
+  return buf;
+}
+
+/* Copies the string value of "key" into out; returns 0 if found */
+static int json_string(const char *json, const char *key, char *out, size_t outlen) {
+  const char *p, *q;
+  char pattern[64];
+
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+  p = strstr(json, pattern);
+  if(!p || !(p = strchr(p + strlen(pattern), '"')) || !(q = strchr(p + 1, '"')))
+    return -1;
+  snprintf(out, outlen, "%.*s", (int)(q - p - 1), p + 1);
+  return 0;
+}
+
+/* Parses the "results" object of a baseline written by perf_gate_save */
+static size_t parse_results(const char *json, struct entry *base, size_t maxbase) {
+  const char *p, *q;
+  char *end;
+  size_t n = 0, cap;
+  uint64_t *t;
+
+  p = strstr(json, "\"results\"");
+  if(!p || !(p = strchr(p, '{')))
+    return 0;
+
+  while(n < maxbase && (p = strchr(p + 1, '"')) && (q = strchr(p + 1, '"'))) {
+    set_name(&base[n], p + 1, (size_t)(q - p - 1));
+    p = strchr(q, '[');
+    if(!p)
+      break;
+
+    cap = 1024;
+    base[n].t = malloc(cap*sizeof(uint64_t));
+    base[n].tlen = 0;
+    for(p++; base[n].t; p = end) {
+      p += strspn(p, " \t\r\n,");
+      if(*p == ']' || *p == '\0')
+        break;
+      if(base[n].tlen == cap) {
+        cap *= 2;
+        t = realloc(base[n].t, cap*sizeof(uint64_t));
+        if(!t) {
+          free(base[n].t);
+          base[n].t = NULL;
+          break;
+        }
+        base[n].t = t;
+      }
+      base[n].t[base[n].tlen++] = strtoull(p, &end, 10);
+      if(end == p)
+        break;
+    }
+    if(!base[n].t || base[n].tlen == 0)
+      break;
+    qsort(base[n].t, base[n].tlen, sizeof(uint64_t), cmp_uint64);
+    n++;
+  }
+
+  return n;
+}
+
+/*************************************************
+* Name:        mann_whitney_p
+*
+* Description: One-sided Mann-Whitney U test with normal approximation,
+*              continuity and tie correction. Small p-values mean that the
+*              samples in b tend to be larger than those in a.
+*
+* Arguments:   - const uint64_t *a: sorted samples of the baseline
+*              - size_t na: number of samples in a
+*              - const uint64_t *b: sorted samples of the new build
+*              - size_t nb: number of samples in b
+*
+* Returns p-value
+**************************************************/
+static double mann_whitney_p(const uint64_t *a, size_t na, const uint64_t *b, size_t nb) {
+  size_t i = 0, j = 0, ta, tb;
+  double u = 0, ties = 0, t, n = (double)(na + nb), sigma, z;
+  uint64_t v;
+
+  /* Walk both sorted lists group by group of equal values; each element of
+   * b scores 1 for every smaller and 1/2 for every equal element of a */
+  while(i < na || j < nb) {
+    if(j == nb || (i < na && a[i] < b[j]))
+      v = a[i];
+    else
+      v = b[j];
+    for(ta = 0; i < na && a[i] == v; i++, ta++);
+    for(tb = 0; j < nb && b[j] == v; j++, tb++);
+    u += (double)tb * ((double)(i - ta) + 0.5*(double)ta);
+    t = (double)(ta + tb);
+    ties += t*t*t - t;
+  }
+
+  sigma = sqrt((double)na*(double)nb/12 * ((n + 1) - ties/(n*(n - 1))));
+  if(sigma == 0)
+    return 1;
+  z = (u - (double)na*(double)nb/2 - 0.5)/sigma;
+  return 0.5*erfc(z/sqrt(2));
+}
+
+/*************************************************
+* Name:        perf_gate_compare
+*
+* Description: Compares the registered samples against a baseline and prints
+*              one line per primitive found in both.
+*
+* Arguments:   - const char *path: baseline written by perf_gate_save
+*              - const char *impl: implementation the samples belong to
+*              - double threshold: tolerated relative slowdown of the median
+*              - double alpha: significance level
+*
+* Returns number of regressions, or -1 if the baseline cannot be used
+**************************************************/
+int perf_gate_compare(const char *path, const char *impl, double threshold, double alpha) {
+  size_t i, j, nbase;
+  int regressions = 0;
+  char *json, str[512], host[512];
+  double m0, m1, p;
+  struct entry base[MAXENTRIES];
+
+  json = read_file(path);
+  if(!json) {
+    fprintf(stderr, "ERROR: cannot read baseline %s\n", path);
+    return -1;
+  }
+
+  if(json_string(json, "impl", str, sizeof(str))) {
+    fprintf(stderr, "ERROR: baseline %s names no implementation\n", path);
+    free(json);
+    return -1;
+  }
+  if(strcmp(str, impl)) {
+    fprintf(stderr, "ERROR: baseline %s is for %s, not %s\n", path, str, impl);
+    free(json);
+    return -1;
+  }
+  host_id(host, sizeof(host));
+  if(json_string(json, "host", str, sizeof(str)) == 0 && strcmp(str, host))
+    fprintf(stderr, "WARNING: baseline was taken on a different host (%s)\n", str);
+
+  nbase = parse_results(json, base, MAXENTRIES);
+  free(json);
+  if(nbase == 0) {
+    fprintf(stderr, "ERROR: no results in baseline %s\n", path);
+    return -1;
+  }
+
+  printf("%-34s %12s %12s %8s %10s\n", "primitive", "baseline", "median", "change", "p");
+  for(i = 0; i < nentries; i++) {
+    for(j = 0; j < nbase && strcmp(base[j].name, entries[i].name); j++);
+    if(j == nbase) {
+      printf("%-34s %12s\n", entries[i].name, "(new)");
+      continue;
+    }
+
+    m0 = median(base[j].t, base[j].tlen);
+    m1 = median(entries[i].t, entries[i].tlen);
+    p = mann_whitney_p(base[j].t, base[j].tlen, entries[i].t, entries[i].tlen);
+    printf("%-34s %12.0f %12.0f %+7.1f%% %10.2g", entries[i].name, m0, m1,
+           m0 > 0 ? 100*(m1 - m0)/m0 : 0, p);
+    if(p < alpha && m1 > m0*(1 + threshold)) {
+      printf("  REGRESSION");
+      regressions++;
+    }
+    printf("\n");
+  }
+
+  for(j = 0; j < nbase; j++)
+    free(base[j].t);
+  return regressions;
+}
@@ -0,0 +1,11 @@
+#ifndef PERF_GATE_H
+#define PERF_GATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void perf_gate_add(const char *name, const uint64_t *t, size_t tlen);
+int perf_gate_save(const char *path, const char *impl);
+int perf_gate_compare(const char *path, const char *impl, double threshold, double alpha);
+
+#endif
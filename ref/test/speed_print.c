@@ -28,21 +28,23 @@ static uint64_t average(uint64_t *t, size_t tlen) {
   return acc/tlen;
 }
 
+/* t holds the cycle counts of tlen runs, each taken as cpucycles_stop()
+ * minus cpucycles_start(); on return they are overhead-corrected and in
+ * ascending order */
 void print_results(const char *s, uint64_t *t, size_t tlen) {
   size_t i;
   static uint64_t overhead = -1;
 
-  if(tlen < 2) {
-    fprintf(stderr, "ERROR: Need a least two cycle counts!\n");
+  if(tlen < 1) {
+    fprintf(stderr, "ERROR: Need a least one cycle count!\n");
     return;
   }
 
   if(overhead  == (uint64_t)-1)
     overhead = cpucycles_overhead();
 
-  tlen--;
   for(i=0;i<tlen;++i)
-    t[i] = t[i+1] - t[i] - overhead;
+    t[i] = (t[i] > overhead) ? t[i] - overhead : 0;
 
   printf("%s\n", s);
   printf("median: %llu cycles/ticks\n", (unsigned long long)median(t, tlen));
@@ -0,0 +1,291 @@
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <malloc.h>
+#include "../kem.h"
+#include "../params.h"
+
+#define NRUNS 16
+#define STACKSIZE (1 << 20)
+#define PAINT 0xA5
+#define NTOP 12
+
+/* Measurement of the memory actually used by the KEM operations:
+ *
+ * - peak stack: every operation runs on a thread whose stack is memory
+ *   painted with a known pattern beforehand; after the thread has finished
+ *   the deepest overwritten byte gives the peak stack depth. The depth of an
+ *   empty thread (TCB, TLS, start routine) is measured the same way and
+ *   subtracted.
+ * - heap: the binary is linked with --wrap=malloc,calloc,realloc,free (see
+ *   the footprint target in the Makefile), so every allocation made by the
+ *   library code goes through the counters below.
+ * - static per-function stack: the .su files written by -fstack-usage for the
+ *   same build are passed on the command line and summarized. */
+
+static uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+static uint8_t sk[CRYPTO_SECRETKEYBYTES];
+static uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+static uint8_t key_a[CRYPTO_BYTES];
+static uint8_t key_b[CRYPTO_BYTES];
+
+static int counting;
+static size_t heap_cur, heap_peak, heap_calls;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t nmemb, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+void __wrap_free(void *ptr);
+
+static void heap_add(void *p)
+{
+  if(!counting || p == NULL)
+    return;
+  heap_calls++;
+  heap_cur += malloc_usable_size(p);
+  if(heap_cur > heap_peak)
+    heap_peak = heap_cur;
+}
+
+static void heap_sub(void *p)
+{
+  if(!counting || p == NULL)
+    return;
+  heap_cur -= malloc_usable_size(p);
+}
+
+void *__wrap_malloc(size_t size)
+{
+  void *p = __real_malloc(size);
+  heap_add(p);
+  return p;
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+  void *p = __real_calloc(nmemb, size);
+  heap_add(p);
+  return p;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  void *p;
+  heap_sub(ptr);
+  p = __real_realloc(ptr, size);
+  heap_add(p ? p : ptr);
+  return p;
+}
+
+void __wrap_free(void *ptr)
+{
+  heap_sub(ptr);
+  __real_free(ptr);
+}
+
+static void op_none(void)
+{
+}
+
+static void op_keypair(void)
+{
+  crypto_kem_keypair(pk, sk);
+}
+
+static void op_enc(void)
+{
+  crypto_kem_enc(ct, key_b, pk);
+}
+
+static void op_dec(void)
+{
+  crypto_kem_dec(key_a, ct, sk);
+}
+
+static void *run_op(void *arg)
+{
+  void (*op)(void) = *(void (**)(void))arg;
+
+  counting = 1;
+  op();
+  counting = 0;
+  return NULL;
+}
+
+/*************************************************
+* Name:        painted_depth
+*
+* Description: Runs op on a thread with a freshly painted stack and returns
+*              the number of bytes at the top of the stack that were
+*              overwritten. Assumes a downward-growing stack.
+*
+* Arguments:   - void (*op)(void): operation to measure
+*
+* Returns number of bytes used, or 0 on failure
+**************************************************/
+static size_t painted_depth(void (*op)(void))
+{
+  size_t i;
+  uint8_t *stack;
+  pthread_t thread;
+  pthread_attr_t attr;
+
+  stack = mmap(NULL, STACKSIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(stack == MAP_FAILED)
+    return 0;
+  memset(stack, PAINT, STACKSIZE);
+
+  if(pthread_attr_init(&attr)
+     || pthread_attr_setstack(&attr, stack, STACKSIZE)
+     || pthread_create(&thread, &attr, run_op, &op)
+     || pthread_join(thread, NULL)) {
+    munmap(stack, STACKSIZE);
+    return 0;
+  }
+  pthread_attr_destroy(&attr);
+
+  for(i = 0; i < STACKSIZE && stack[i] == PAINT; i++);
+  munmap(stack, STACKSIZE);
+  return STACKSIZE - i;
+}
+
+struct su_entry {
+  char func[128];
+  char file[128];
+  long bytes;
+  char kind[32];
+};
+
+static int cmp_su(const void *a, const void *b)
+{
+  const struct su_entry *x = a, *y = b;
+  return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+/* .su lines look like "kem.c:51:5:crypto_kem_keypair_derand\t48\tstatic" */
+static size_t read_su(struct su_entry **entries, size_t n, size_t *cap, const char *path)
+{
+  char line[512], *loc, *func, *tab;
+  struct su_entry *e;
+  FILE *f = fopen(path, "r");
+
+  if(!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return n;
+  }
+
+  while(fgets(line, sizeof(line), f)) {
+    tab = strchr(line, '\t');
+    func = strrchr(line, ':');
+    if(!tab || !func || func > tab)
+      continue;
+    *tab++ = '\0';
+    *func++ = '\0';
+    loc = strchr(line, ':');
+    if(loc)
+      *loc = '\0';
+
+    if(n == *cap) {
+      *cap = *cap ? 2*(*cap) : 64;
+      e = realloc(*entries, *cap * sizeof(**entries));
+      if(!e)
+        break;
+      *entries = e;
+    }
+    e = &(*entries)[n++];
+    snprintf(e->file, sizeof(e->file), "%.*s", (int)sizeof(e->file) - 1, line);
+    snprintf(e->func, sizeof(e->func), "%.*s", (int)sizeof(e->func) - 1, func);
+    e->bytes = strtol(tab, &tab, 10);
+    snprintf(e->kind, sizeof(e->kind), "%.*s", (int)sizeof(e->kind) - 1, tab + strspn(tab, "\t "));
+    e->kind[strcspn(e->kind, "\r\n")] = '\0';
+  }
+
+  fclose(f);
+  return n;
+}
+
+static void print_su(int argc, char **argv)
+{
+  int i;
+  size_t n = 0, cap = 0, j;
+  struct su_entry *entries = NULL;
+
+  for(i = 1; i < argc; i++)
+    n = read_su(&entries, n, &cap, argv[i]);
+  if(n == 0) {
+    printf("\nno -fstack-usage data (pass the .su files of this build)\n");
+    free(entries);
+    return;
+  }
+
+  qsort(entries, n, sizeof(*entries), cmp_su);
+  printf("\nlargest frames (-fstack-usage, %zu functions):\n", n);
+  for(j = 0; j < n && j < NTOP; j++)
+    printf("  %6ld bytes  %-48s %-20s %s\n", entries[j].bytes, entries[j].func,
+           entries[j].file, entries[j].kind);
+  free(entries);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int i, j;
+  size_t base, depth, peak, worst = 0;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  static const struct {
+    const char *name;
+    void (*op)(void);
+  } ops[] = {
+    { "crypto_kem_keypair", op_keypair },
+    { "crypto_kem_enc", op_enc },
+    { "crypto_kem_dec", op_dec },
+  };
+
+  base = painted_depth(op_none);
+  if(base == 0) {
+    fprintf(stderr, "ERROR cannot run measurement thread\n");
+    return 1;
+  }
+
+  printf("%s\n", CRYPTO_ALGNAME);
+  printf("thread baseline: %zu bytes (subtracted)\n\n", base);
+  printf("%-20s %12s %12s %12s\n", "operation", "peak stack", "peak heap", "allocations");
+  for(i = 0; i < sizeof(ops)/sizeof(ops[0]); i++) {
+    peak = 0;
+    heap_cur = heap_peak = heap_calls = 0;
+    for(j = 0; j < NRUNS; j++) {
+      /* keypair and enc refresh the inputs of the later operations */
+      if(i > 0)
+        op_keypair();
+      if(i > 1)
+        op_enc();
+      depth = painted_depth(ops[i].op);
+      if(depth > peak)
+        peak = depth;
+    }
+    peak = (peak > base) ? peak - base : 0;
+    if(peak > worst)
+      worst = peak;
+    printf("%-20s %12zu %12zu %12zu\n", ops[i].name, peak, heap_peak, heap_calls/NRUNS);
+  }
+
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    fprintf(stderr, "ERROR keys\n");
+    return 1;
+  }
+
+  printf("\nsuggested worker stack: %zu bytes (worst peak + baseline, page aligned)\n",
+         (worst + base + page - 1) / page * page);
+
+  print_su(argc, argv);
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../kem.h"
+#include "../keystore.h"
+#include "../randombytes.h"
+
+#define NKEYS 1000
+#define NTESTS 200
+
+static uint64_t ids[NKEYS];
+static uint8_t pks[NKEYS][CRYPTO_PUBLICKEYBYTES];
+static uint8_t sks[NKEYS][CRYPTO_SECRETKEYBYTES];
+
+static int corrupt(const char *path, long offset)
+{
+  int c;
+  FILE *f = fopen(path, "r+b");
+
+  if(!f)
+    return -1;
+  fseek(f, offset, SEEK_SET);
+  c = fgetc(f);
+  fseek(f, offset, SEEK_SET);
+  fputc(c ^ 1, f);
+  return fclose(f);
+}
+
+/* Locked memory of this process in kB, or -1 if unknown */
+static long locked_kb(void)
+{
+  char line[128];
+  long kb = -1;
+  FILE *f = fopen("/proc/self/status", "r");
+
+  if(!f)
+    return -1;
+  while(fgets(line, sizeof(line), f))
+    if(sscanf(line, "VmLck: %ld kB", &kb) == 1)
+      break;
+  fclose(f);
+  return kb;
+}
+
+/* Keys 0 and 1 share a page: unlocking one must keep the other locked */
+static int check_locks(const keystore *ks)
+{
+  long kb0, kb1;
+
+  kb0 = locked_kb();
+  if(keystore_hot(ks, ids[0], 1)) {
+    printf("keystore: mlock not permitted, lock test skipped\n");
+    return 0;
+  }
+  if(keystore_hot(ks, ids[1], 1) || keystore_hot(ks, ids[1], 1)) {
+    fprintf(stderr, "ERROR keystore_hot\n");
+    return 1;
+  }
+  kb1 = locked_kb();
+  if(keystore_cold(ks, ids[0]) || keystore_cold(ks, ids[0])
+     || (kb1 >= 0 && locked_kb() != kb1)) {
+    fprintf(stderr, "ERROR keystore_cold unlocked a page of a locked key\n");
+    return 1;
+  }
+  if(keystore_cold(ks, ids[1]) || (kb0 >= 0 && locked_kb() != kb0)) {
+    fprintf(stderr, "ERROR keystore_cold left pages locked\n");
+    return 1;
+  }
+  if(keystore_cold(ks, 8) != -1) {
+    fprintf(stderr, "ERROR keystore_cold of missing id\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void)
+{
+  unsigned int i, j;
+  char path[] = "/tmp/test_keystoreXXXXXX";
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  uint64_t dup[2] = {1, 1};
+  keystore ks;
+  int fd;
+
+  fd = mkstemp(path);
+  if(fd < 0) {
+    fprintf(stderr, "ERROR cannot create temporary file\n");
+    return 1;
+  }
+  close(fd);
+
+  /* Sparse ids that collide in the low bits */
+  for(i=0;i<NKEYS;i++) {
+    ids[i] = ((uint64_t)i << 32) | 7;
+    crypto_kem_keypair(pks[i], sks[i]);
+  }
+
+  if(keystore_create(path, ids, &sks[0][0], NKEYS) || keystore_open(&ks, path)) {
+    fprintf(stderr, "ERROR keystore_create/keystore_open\n");
+    goto fail;
+  }
+
+  for(i=0;i<NTESTS;i++) {
+    randombytes((uint8_t *)&j, sizeof(j));
+    j %= NKEYS;
+    crypto_kem_enc(ct, key_b, pks[j]);
+    if(keystore_hot(&ks, ids[j], 0)
+       || crypto_kem_dec_by_id(key_a, ct, &ks, ids[j])
+       || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+      fprintf(stderr, "ERROR keys of id %llu\n", (unsigned long long)ids[j]);
+      goto fail;
+    }
+  }
+
+  if(keystore_find(&ks, 8) || crypto_kem_dec_by_id(key_a, ct, &ks, 8) != -1) {
+    fprintf(stderr, "ERROR found missing id\n");
+    goto fail;
+  }
+
+  if(check_locks(&ks))
+    goto fail;
+  keystore_close(&ks);
+
+  if(keystore_create(path, dup, &sks[0][0], 2) == 0) {
+    fprintf(stderr, "ERROR accepted duplicate ids\n");
+    goto fail;
+  }
+
+  if(keystore_create(path, ids, &sks[0][0], 1) || corrupt(path, 0) || keystore_open(&ks, path) == 0) {
+    fprintf(stderr, "ERROR accepted corrupted header\n");
+    goto fail;
+  }
+
+  unlink(path);
+  printf("keystore: %d keys OK\n", NKEYS);
+  return 0;
+
+fail:
+  unlink(path);
+  return 1;
+}
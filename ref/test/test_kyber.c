@@ -5,6 +5,8 @@
 #include "../randombytes.h"
 
 #define NTESTS 1000
+/* Not a multiple of any group size, so that partial groups are tested */
+#define BATCH 7
 
 static int test_keys(void)
 {
@@ -94,6 +96,145 @@ static int test_invalid_ciphertext(void)
   return 0;
 }
 
+static int test_pkctx(void)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct_a[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t ct_b[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  uint8_t coins[32];
+  kem_pkctx ctx;
+
+  crypto_kem_keypair(pk, sk);
+  crypto_kem_pkctx_init(&ctx, pk);
+
+  //Encapsulation with the cached H(pk) must match the plain one
+  randombytes(coins, sizeof(coins));
+  crypto_kem_enc_derand(ct_a, key_a, pk, coins);
+  crypto_kem_enc_pkctx_derand(ct_b, key_b, &ctx, coins);
+
+  if(memcmp(ct_a, ct_b, CRYPTO_CIPHERTEXTBYTES) || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR pkctx derand\n");
+    return 1;
+  }
+
+  crypto_kem_enc_pkctx(ct_b, key_b, &ctx);
+  crypto_kem_dec(key_a, ct_b, sk);
+
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR pkctx keys\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int test_skctx(void)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  kem_skctx ctx;
+
+  crypto_kem_keypair(pk, sk);
+  crypto_kem_skctx_init(&ctx, sk);
+
+  //Valid ciphertext: both paths return the shared key
+  crypto_kem_enc(ct, key_b, pk);
+  crypto_kem_dec_skctx(key_a, ct, &ctx);
+
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR skctx keys\n");
+    return 1;
+  }
+
+  //Invalid ciphertext: both paths return the same rejection key
+  ct[0] ^= 1;
+  crypto_kem_dec(key_a, ct, sk);
+  crypto_kem_dec_skctx(key_b, ct, &ctx);
+
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR skctx rejection key\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int test_expanded(void)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  static kem_expanded_sk esk;
+
+  crypto_kem_keypair(pk, sk);
+  crypto_kem_sk_expand(&esk, sk);
+
+  //Valid ciphertext: both paths return the shared key
+  crypto_kem_enc(ct, key_b, pk);
+  crypto_kem_dec_expanded(key_a, ct, &esk);
+
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR expanded keys\n");
+    return 1;
+  }
+
+  //Invalid ciphertext: both paths return the same rejection key
+  ct[0] ^= 1;
+  crypto_kem_dec(key_a, ct, sk);
+  crypto_kem_dec_expanded(key_b, ct, &esk);
+
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR expanded rejection key\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int test_batch(void)
+{
+  unsigned int i;
+  uint8_t pk[BATCH][CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[BATCH][CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[BATCH][CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[BATCH][CRYPTO_BYTES];
+  uint8_t key_b[BATCH][CRYPTO_BYTES];
+
+  //One key per ciphertext, one of them invalid
+  for(i=0;i<BATCH;i++) {
+    crypto_kem_keypair(pk[i], sk[i]);
+    crypto_kem_enc(ct[i], key_b[i], pk[i]);
+  }
+  ct[BATCH/2][0] ^= 1;
+  crypto_kem_dec(key_b[BATCH/2], ct[BATCH/2], sk[BATCH/2]);
+  crypto_kem_dec_batch(&key_a[0][0], &ct[0][0], &sk[0][0], CRYPTO_SECRETKEYBYTES, BATCH);
+
+  if(memcmp(key_a, key_b, sizeof(key_a))) {
+    printf("ERROR batch keys\n");
+    return 1;
+  }
+
+  //All ciphertexts for the same key
+  for(i=0;i<BATCH;i++)
+    crypto_kem_enc(ct[i], key_b[i], pk[0]);
+  crypto_kem_dec_batch(&key_a[0][0], &ct[0][0], &sk[0][0], 0, BATCH);
+
+  if(memcmp(key_a, key_b, sizeof(key_a))) {
+    printf("ERROR batch keys with shared private key\n");
+    return 1;
+  }
+
+  return 0;
+}
+
 int main(void)
 {
   unsigned int i;
@@ -103,6 +244,10 @@ int main(void)
     r  = test_keys();
     r |= test_invalid_sk_a();
     r |= test_invalid_ciphertext();
+    r |= test_pkctx();
+    r |= test_skctx();
+    r |= test_expanded();
+    r |= test_batch();
     if(r)
       return 1;
   }
@@ -0,0 +1,95 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../kem.h"
+#include "../lockstep.h"
+#include "../randombytes.h"
+
+/* Not a multiple of the lane count, so that a padded group is tested */
+#define NOPS (2*KYBER_LANES+3)
+#define NTESTS 10
+
+static uint8_t coins[NOPS][2*KYBER_SYMBYTES];
+static uint8_t pk[NOPS][CRYPTO_PUBLICKEYBYTES];
+static uint8_t sk[NOPS][CRYPTO_SECRETKEYBYTES];
+static uint8_t pk_x[NOPS][CRYPTO_PUBLICKEYBYTES];
+static uint8_t sk_x[NOPS][CRYPTO_SECRETKEYBYTES];
+static uint8_t ct[NOPS][CRYPTO_CIPHERTEXTBYTES];
+static uint8_t key_a[NOPS][CRYPTO_BYTES];
+static uint8_t key_b[NOPS][CRYPTO_BYTES];
+static uint8_t key_x[NOPS][CRYPTO_BYTES];
+
+static int test_lockstep(void)
+{
+  unsigned int i;
+
+  randombytes(coins[0], sizeof(coins));
+  for(i=0;i<NOPS;i++)
+    crypto_kem_keypair_derand(pk[i], sk[i], coins[i]);
+  crypto_kem_keypair_derand_lockstep(pk_x[0], sk_x[0], coins[0], NOPS);
+  if(memcmp(pk, pk_x, sizeof(pk)) || memcmp(sk, sk_x, sizeof(sk))) {
+    printf("ERROR keypair_derand_lockstep\n");
+    return 1;
+  }
+
+  /* One key per cipher text; distort every third cipher text */
+  for(i=0;i<NOPS;i++) {
+    crypto_kem_enc(ct[i], key_b[i], pk[i]);
+    if(i % 3 == 1)
+      ct[i][coins[i][0] % CRYPTO_CIPHERTEXTBYTES] ^= 1 + (coins[i][1] & 0x7F);
+    crypto_kem_dec(key_a[i], ct[i], sk[i]);
+  }
+  crypto_kem_dec_lockstep(key_x[0], ct[0], sk[0], CRYPTO_SECRETKEYBYTES, NOPS);
+  if(memcmp(key_a, key_x, sizeof(key_a))) {
+    printf("ERROR dec_lockstep\n");
+    return 1;
+  }
+  for(i=0;i<NOPS;i++) {
+    if((i % 3 == 1) == !memcmp(key_x[i], key_b[i], CRYPTO_BYTES)) {
+      printf("ERROR dec_lockstep %s cipher text\n", (i % 3 == 1) ? "invalid" : "valid");
+      return 1;
+    }
+  }
+
+  /* All cipher texts under one key */
+  for(i=0;i<NOPS;i++) {
+    crypto_kem_enc(ct[i], key_b[i], pk[0]);
+    if(i % 3 == 1)
+      ct[i][coins[i][0] % CRYPTO_CIPHERTEXTBYTES] ^= 1 + (coins[i][1] & 0x7F);
+    crypto_kem_dec(key_a[i], ct[i], sk[0]);
+  }
+  crypto_kem_dec_lockstep(key_x[0], ct[0], sk[0], 0, NOPS);
+  if(memcmp(key_a, key_x, sizeof(key_a))) {
+    printf("ERROR dec_lockstep single key\n");
+    return 1;
+  }
+
+  /* Random key pairs from the lockstep path work with the scalar path */
+  crypto_kem_keypair_lockstep(pk_x[0], sk_x[0], 3);
+  for(i=0;i<3;i++) {
+    crypto_kem_enc(ct[i], key_b[i], pk_x[i]);
+    crypto_kem_dec(key_a[i], ct[i], sk_x[i]);
+    if(memcmp(key_a[i], key_b[i], CRYPTO_BYTES)) {
+      printf("ERROR keypair_lockstep\n");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  unsigned int i;
+  int r;
+
+  for(i=0;i<NTESTS;i++) {
+    r = test_lockstep();
+    if(r)
+      return 1;
+  }
+
+  printf("lockstep: %d lanes, %d operations OK\n", KYBER_LANES, NOPS);
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include "../kem.h"
+#include "../offline.h"
+#include "../randombytes.h"
+
+#define CAPACITY 8
+#define NTESTS 100
+
+static uint8_t ct[NTESTS][CRYPTO_CIPHERTEXTBYTES];
+
+static int check(kem_offline *o, const uint8_t *sk, unsigned int n)
+{
+  unsigned int i, j;
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+
+  for(i=0;i<n;i++) {
+    crypto_kem_enc_online(ct[i], key_b, o);
+    crypto_kem_dec(key_a, ct[i], sk);
+    if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+      printf("ERROR keys\n");
+      return 1;
+    }
+    for(j=0;j<i;j++) {
+      if(!memcmp(ct[i], ct[j], CRYPTO_CIPHERTEXTBYTES)) {
+        printf("ERROR cipher text handed out twice\n");
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  unsigned int i;
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  kem_offline *o;
+
+  crypto_kem_keypair(pk, sk);
+
+  /* Filled by the caller; the last pairs come from the fallback */
+  o = kem_offline_new(pk, CAPACITY, 0);
+  if(!o || kem_offline_fill(o, 3) != 3 || kem_offline_fill(o, NTESTS) != CAPACITY-3
+     || kem_offline_available(o) != CAPACITY) {
+    printf("ERROR kem_offline_fill\n");
+    return 1;
+  }
+  if(check(o, sk, CAPACITY+2) || kem_offline_available(o) != 0)
+    return 1;
+  kem_offline_free(o);
+
+  /* Topped up in the background */
+  o = kem_offline_new(pk, CAPACITY, 1);
+  if(!o) {
+    printf("ERROR kem_offline_new\n");
+    return 1;
+  }
+  for(i=0;i<1000 && kem_offline_available(o) < CAPACITY;i++)
+    sched_yield();
+  if(check(o, sk, NTESTS))
+    return 1;
+  kem_offline_free(o);
+
+  if(kem_offline_new(pk, 0, 0) != NULL) {
+    printf("ERROR accepted capacity 0\n");
+    return 1;
+  }
+
+  printf("offline: %d pairs OK\n", NTESTS);
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../kem.h"
+#include "../pkcache.h"
+#include "../randombytes.h"
+
+#define NKEYS 12
+#define NTHREADS 4
+#define NTESTS 100
+
+static uint8_t pk[NKEYS][CRYPTO_PUBLICKEYBYTES];
+static uint8_t sk[NKEYS][CRYPTO_SECRETKEYBYTES];
+
+/* Same output as crypto_kem_enc_derand and decapsulates correctly */
+static int check(kem_pkcache *c, const uint8_t *pkey, const uint8_t *skey)
+{
+  uint8_t coins[KYBER_SYMBYTES];
+  uint8_t ct_a[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t ct_b[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_derand(ct_a, key_a, pkey, coins);
+  crypto_kem_enc_cached_derand(ct_b, key_b, pkey, coins, c);
+  if(memcmp(ct_a, ct_b, CRYPTO_CIPHERTEXTBYTES) || memcmp(key_a, key_b, CRYPTO_BYTES))
+    return 1;
+  if(skey) {
+    crypto_kem_dec(key_a, ct_b, skey);
+    if(memcmp(key_a, key_b, CRYPTO_BYTES))
+      return 1;
+  }
+  return 0;
+}
+
+static void *worker(void *arg)
+{
+  unsigned int i;
+  uint8_t r;
+  kem_pkcache *c = arg;
+
+  for(i=0;i<NTESTS;i++) {
+    randombytes(&r, 1);
+    if(check(c, pk[r % NKEYS], NULL))
+      return arg;
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  unsigned int i;
+  uint8_t pk_t[CRYPTO_PUBLICKEYBYTES];
+  pthread_t threads[NTHREADS];
+  void *ret;
+  int fail = 0;
+  kem_pkcache *c;
+  kem_pkcache_stats st;
+
+  for(i=0;i<NKEYS;i++)
+    crypto_kem_keypair(pk[i], sk[i]);
+
+  /* Room for a few keys only */
+  c = kem_pkcache_new(5*(sizeof(kem_expanded_pk)+CRYPTO_PUBLICKEYBYTES));
+  if(!c) {
+    printf("ERROR kem_pkcache_new\n");
+    return 1;
+  }
+  kem_pkcache_get_stats(c, &st);
+  if(st.capacity < 2 || st.capacity >= NKEYS) {
+    printf("ERROR capacity\n");
+    return 1;
+  }
+
+  /* Miss, then hit */
+  if(check(c, pk[0], sk[0]) || check(c, pk[0], sk[0])) {
+    printf("ERROR enc_cached\n");
+    return 1;
+  }
+  kem_pkcache_get_stats(c, &st);
+  if(st.hits != 1 || st.misses != 1 || st.evictions != 0 || st.entries != 1) {
+    printf("ERROR counters\n");
+    return 1;
+  }
+
+  /* More keys than fit */
+  for(i=0;i<NKEYS;i++) {
+    if(check(c, pk[i], sk[i])) {
+      printf("ERROR enc_cached with eviction\n");
+      return 1;
+    }
+  }
+  kem_pkcache_get_stats(c, &st);
+  if(st.misses != NKEYS || st.entries != st.capacity || st.evictions != NKEYS - st.capacity) {
+    printf("ERROR counters with eviction\n");
+    return 1;
+  }
+
+  /* Same seed, different key */
+  memcpy(pk_t, pk[NKEYS-1], CRYPTO_PUBLICKEYBYTES);
+  pk_t[0] ^= 1;
+  if(check(c, pk_t, NULL) || check(c, pk[NKEYS-1], sk[NKEYS-1])) {
+    printf("ERROR enc_cached with shared seed\n");
+    return 1;
+  }
+
+  for(i=0;i<NTHREADS;i++)
+    pthread_create(&threads[i], NULL, worker, c);
+  for(i=0;i<NTHREADS;i++) {
+    pthread_join(threads[i], &ret);
+    fail |= ret != NULL;
+  }
+  if(fail) {
+    printf("ERROR enc_cached from several threads\n");
+    return 1;
+  }
+  kem_pkcache_get_stats(c, &st);
+  if(st.hits + st.misses != NKEYS + 4 + NTHREADS*NTESTS) {
+    printf("ERROR counters from several threads\n");
+    return 1;
+  }
+  kem_pkcache_free(c);
+
+  if(kem_pkcache_new(sizeof(kem_expanded_pk)) != NULL) {
+    printf("ERROR accepted budget below one entry\n");
+    return 1;
+  }
+
+  printf("pkcache: %u of %d keys cached OK\n", (unsigned int)st.capacity, NKEYS);
+  return 0;
+}
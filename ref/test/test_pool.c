@@ -0,0 +1,93 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../kem.h"
+#include "../pool.h"
+#include "../randombytes.h"
+
+#define NTESTS 200
+
+static int test_pool(kem_pool *pool)
+{
+  unsigned int i;
+  uint8_t coins[3*KYBER_SYMBYTES];
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES], pk_p[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES], sk_p[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES], ct_p[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES], key_b[CRYPTO_BYTES];
+
+  for(i=0;i<NTESTS;i++) {
+    randombytes(coins, sizeof(coins));
+
+    crypto_kem_keypair_derand(pk, sk, coins);
+    crypto_kem_keypair_derand_pool(pk_p, sk_p, coins, pool);
+    if(memcmp(pk, pk_p, sizeof(pk)) || memcmp(sk, sk_p, sizeof(sk))) {
+      printf("ERROR keypair_derand_pool\n");
+      return 1;
+    }
+
+    crypto_kem_enc_derand(ct, key_a, pk, coins+2*KYBER_SYMBYTES);
+    crypto_kem_enc_derand_pool(ct_p, key_b, pk, coins+2*KYBER_SYMBYTES, pool);
+    if(memcmp(ct, ct_p, sizeof(ct)) || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+      printf("ERROR enc_derand_pool\n");
+      return 1;
+    }
+
+    /* Every other cipher text invalid */
+    if(i & 1)
+      ct[coins[0] % CRYPTO_CIPHERTEXTBYTES] ^= 1 + (coins[1] & 0x7F);
+    crypto_kem_dec(key_a, ct, sk);
+    crypto_kem_dec_pool(key_b, ct, sk, pool);
+    if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+      printf("ERROR dec_pool\n");
+      return 1;
+    }
+  }
+
+  crypto_kem_keypair_pool(pk, sk, pool);
+  crypto_kem_enc_pool(ct, key_b, pk, pool);
+  crypto_kem_dec_pool(key_a, ct, sk, pool);
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR keys\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static void *caller(void *pool)
+{
+  return (void *)(size_t)test_pool(pool);
+}
+
+int main(void)
+{
+  unsigned int n;
+  kem_pool *pool;
+  pthread_t other;
+  void *r;
+
+  for(n=0;n<4;n++) {
+    pool = kem_pool_new(n);
+    if(!pool) {
+      printf("ERROR kem_pool_new\n");
+      return 1;
+    }
+    if(test_pool(pool))
+      return 1;
+
+    /* Two callers sharing the pool */
+    if(pthread_create(&other, NULL, caller, pool)) {
+      printf("ERROR pthread_create\n");
+      return 1;
+    }
+    if(test_pool(pool) || pthread_join(other, &r) || r)
+      return 1;
+    kem_pool_free(pool);
+  }
+
+  printf("pool: up to %u helpers OK\n", n-1);
+  return 0;
+}
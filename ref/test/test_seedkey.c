@@ -0,0 +1,177 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "../kem.h"
+#include "../keystore.h"
+#include "../polyx.h"
+#include "../seedkey.h"
+#include "../randombytes.h"
+
+/* Full lockstep groups and a short tail */
+#define NKEYS (2*KYBER_LANES+5)
+#define NTHREADS 4
+#define NTESTS 20
+
+static uint64_t ids[NKEYS];
+static uint8_t seeds[NKEYS][KYBER_SEEDKEYBYTES];
+static uint8_t pks[NKEYS][CRYPTO_PUBLICKEYBYTES];
+static uint8_t sks[NKEYS][CRYPTO_SECRETKEYBYTES];
+static uint8_t sks_x[NKEYS][CRYPTO_SECRETKEYBYTES];
+static uint8_t cts[NKEYS][CRYPTO_CIPHERTEXTBYTES];
+static uint8_t keys[NKEYS][CRYPTO_BYTES];
+
+static void *worker(void *arg)
+{
+  unsigned int i;
+  uint8_t r;
+  uint8_t key[CRYPTO_BYTES];
+  kem_skcache *c = arg;
+
+  for(i=0;i<NTESTS;i++) {
+    randombytes(&r, 1);
+    r %= NKEYS;
+    if(crypto_kem_dec_cached(key, cts[r], c, ids[r]) || memcmp(key, keys[r], CRYPTO_BYTES))
+      return arg;
+  }
+  return NULL;
+}
+
+/* Decapsulates every cipher text through the cache */
+static int check(kem_skcache *c)
+{
+  unsigned int i;
+  uint8_t key[CRYPTO_BYTES];
+
+  for(i=0;i<NKEYS;i++)
+    if(crypto_kem_dec_cached(key, cts[i], c, ids[i]) || memcmp(key, keys[i], CRYPTO_BYTES))
+      return 1;
+  return 0;
+}
+
+int main(void)
+{
+  unsigned int i;
+  char path[] = "/tmp/test_seedkeyXXXXXX";
+  char path_full[] = "/tmp/test_seedkeyXXXXXX";
+  uint8_t key[CRYPTO_BYTES];
+  pthread_t threads[NTHREADS];
+  struct stat st_seeds, st_full;
+  keystore ks, ks_full;
+  kem_skcache *c;
+  kem_skcache_stats st;
+  void *ret;
+  int fd, fail = 0;
+
+  fd = mkstemp(path);
+  if(fd < 0 || close(fd) || (fd = mkstemp(path_full)) < 0 || close(fd)) {
+    fprintf(stderr, "ERROR cannot create temporary file\n");
+    return 1;
+  }
+
+  /* Seeds regenerate the key pairs of crypto_kem_keypair_derand */
+  for(i=0;i<NKEYS;i++) {
+    ids[i] = ((uint64_t)i << 32) | 3;
+    crypto_kem_keypair_seed(pks[i], seeds[i]);
+    crypto_kem_seed_expand(sks[i], seeds[i]);
+    if(memcmp(sks[i] + KYBER_INDCPA_SECRETKEYBYTES, pks[i], CRYPTO_PUBLICKEYBYTES)) {
+      fprintf(stderr, "ERROR seed_expand\n");
+      goto fail;
+    }
+    crypto_kem_enc(cts[i], keys[i], pks[i]);
+  }
+  crypto_kem_seed_expand_batch(sks_x[0], seeds[0], NKEYS);
+  if(memcmp(sks, sks_x, sizeof(sks))) {
+    fprintf(stderr, "ERROR seed_expand_batch\n");
+    goto fail;
+  }
+
+  /* Seed store */
+  if(keystore_create_seeds(path, ids, seeds[0], NKEYS) || keystore_open(&ks, path) || !ks.seeds
+     || keystore_create(path_full, ids, sks[0], NKEYS) || keystore_open(&ks_full, path_full) || ks_full.seeds) {
+    fprintf(stderr, "ERROR keystore_create_seeds/keystore_open\n");
+    goto fail;
+  }
+  for(i=0;i<NKEYS;i++) {
+    if(memcmp(keystore_find(&ks, ids[i]), seeds[i], KYBER_SEEDKEYBYTES)
+       || crypto_kem_dec_by_id(key, cts[i], &ks, ids[i]) || memcmp(key, keys[i], CRYPTO_BYTES)) {
+      fprintf(stderr, "ERROR dec_by_id in seed store\n");
+      goto fail;
+    }
+  }
+
+  /* Cache smaller than the store: load evicts, misses refill */
+  c = kem_skcache_new(&ks, 9*KYBER_EXPANDEDSECRETKEYBYTES);
+  if(!c) {
+    fprintf(stderr, "ERROR kem_skcache_new\n");
+    goto fail;
+  }
+  kem_skcache_get_stats(c, &st);
+  if(st.capacity < 2 || st.capacity >= NKEYS || kem_skcache_load(c, ids, NKEYS) != NKEYS) {
+    fprintf(stderr, "ERROR kem_skcache_load\n");
+    goto fail;
+  }
+  kem_skcache_get_stats(c, &st);
+  if(st.entries != st.capacity || st.evictions != NKEYS - st.capacity || st.hits || st.misses) {
+    fprintf(stderr, "ERROR counters after load\n");
+    goto fail;
+  }
+  if(crypto_kem_dec_cached(key, cts[NKEYS-1], c, ids[NKEYS-1]) || crypto_kem_dec_cached(key, cts[0], c, ids[0])) {
+    fprintf(stderr, "ERROR dec_cached\n");
+    goto fail;
+  }
+  kem_skcache_get_stats(c, &st);
+  if(st.hits != 1 || st.misses != 1) {
+    fprintf(stderr, "ERROR counters\n");
+    goto fail;
+  }
+  if(check(c) || crypto_kem_dec_cached(key, cts[0], c, 5) != -1) {
+    fprintf(stderr, "ERROR dec_cached with eviction\n");
+    goto fail;
+  }
+
+  for(i=0;i<NTHREADS;i++)
+    pthread_create(&threads[i], NULL, worker, c);
+  for(i=0;i<NTHREADS;i++) {
+    pthread_join(threads[i], &ret);
+    fail |= ret != NULL;
+  }
+  kem_skcache_free(c);
+  if(fail) {
+    fprintf(stderr, "ERROR dec_cached from several threads\n");
+    goto fail;
+  }
+
+  /* Cache over a store of full private keys */
+  c = kem_skcache_new(&ks_full, 9*KYBER_EXPANDEDSECRETKEYBYTES);
+  if(!c || kem_skcache_load(c, ids, 3) != 3 || check(c)) {
+    fprintf(stderr, "ERROR kem_skcache with full keys\n");
+    goto fail;
+  }
+  kem_skcache_free(c);
+
+  if(kem_skcache_new(&ks, KYBER_EXPANDEDSECRETKEYBYTES/2) != NULL) {
+    fprintf(stderr, "ERROR accepted budget below one entry\n");
+    goto fail;
+  }
+
+  stat(path, &st_seeds);
+  stat(path_full, &st_full);
+  keystore_close(&ks);
+  keystore_close(&ks_full);
+  unlink(path);
+  unlink(path_full);
+
+  printf("seedkey: %d keys OK, store %ld bytes with seeds, %ld with full keys\n",
+         NKEYS, (long)st_seeds.st_size, (long)st_full.st_size);
+  return 0;
+
+fail:
+  unlink(path);
+  unlink(path_full);
+  return 1;
+}
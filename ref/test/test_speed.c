@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "../kem.h"
 #include "../params.h"
 #include "../indcpa.h"
@@ -10,15 +11,61 @@
 #include "../randombytes.h"
 #include "cpucycles.h"
 #include "speed_print.h"
+#include "perf_gate.h"
 
 #define NTESTS 1000
 
+#define STR(s) #s
+#define XSTR(s) STR(s)
+#define IMPL XSTR(KYBER_NAMESPACE())
+
+/* Measured primitives and API functions as X(name, call). Baselines saved
+ * with --save are keyed by name, so keep the names stable. The gate gets
+ * the raw per-run counts before print_results corrects and sorts them in
+ * place. */
+#define PRIMITIVES(X) \
+  X("gen_a",                          gen_matrix(matrix, seed, 0)) \
+  X("poly_getnoise_eta1",             poly_getnoise_eta1(&ap, seed, 0)) \
+  X("poly_getnoise_eta2",             poly_getnoise_eta2(&ap, seed, 0)) \
+  X("NTT",                            poly_ntt(&ap)) \
+  X("INVNTT",                         poly_invntt_tomont(&ap)) \
+  X("polyvec_basemul_acc_montgomery", polyvec_basemul_acc_montgomery(&ap, &matrix[0], &matrix[1])) \
+  X("poly_tomsg",                     poly_tomsg(ct,&ap)) \
+  X("poly_frommsg",                   poly_frommsg(&ap,ct)) \
+  X("poly_compress",                  poly_compress(ct,&ap)) \
+  X("poly_decompress",                poly_decompress(&ap,ct)) \
+  X("polyvec_compress",               polyvec_compress(ct,&matrix[0])) \
+  X("polyvec_decompress",             polyvec_decompress(&matrix[0],ct)) \
+  X("indcpa_keypair",                 indcpa_keypair_derand(pk, sk, coins32)) \
+  X("indcpa_enc",                     indcpa_enc(ct, key, pk, seed)) \
+  X("indcpa_dec",                     indcpa_dec(key, ct, sk)) \
+  X("kyber_keypair_derand",           crypto_kem_keypair_derand(pk, sk, coins64)) \
+  X("kyber_keypair",                  crypto_kem_keypair(pk, sk)) \
+  X("kyber_encaps_derand",            crypto_kem_enc_derand(ct, key, pk, coins32)) \
+  X("kyber_encaps",                   crypto_kem_enc(ct, key, pk)) \
+  X("kyber_decaps",                   crypto_kem_dec(key, ct, sk)) \
+  X("kyber_sk_expand",                crypto_kem_sk_expand(&esk, sk)) \
+  X("kyber_decaps_expanded",          crypto_kem_dec_expanded(key, ct, &esk)) \
+  X("kyber_decaps_batch (4 ct)",      crypto_kem_dec_batch(batch_ss, batch_ct, sk, 0, 4))
+
 uint64_t t[NTESTS];
 uint8_t seed[KYBER_SYMBYTES] = {0};
+kem_expanded_sk esk;
+uint8_t batch_ct[4*KYBER_CIPHERTEXTBYTES];
+uint8_t batch_ss[4*KYBER_SSBYTES];
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [--save FILE] [--compare FILE] [--threshold PERCENT] [--alpha P]\n", prog);
+}
 
-int main(void)
+int main(int argc, char **argv)
 {
   unsigned int i;
+  int j, regressions;
+  uint64_t t0;
+  const char *save = NULL, *compare = NULL;
+  double threshold = 5, alpha = 0.001;
   uint8_t pk[CRYPTO_PUBLICKEYBYTES];
   uint8_t sk[CRYPTO_SECRETKEYBYTES];
   uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
@@ -28,128 +75,48 @@ int main(void)
   polyvec matrix[KYBER_K];
   poly ap;
 
-  randombytes(coins32, KYBER_SYMBYTES);
-  randombytes(coins64, 2*KYBER_SYMBYTES);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    gen_matrix(matrix, seed, 0);
-  }
-  print_results("gen_a: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_getnoise_eta1(&ap, seed, 0);
-  }
-  print_results("poly_getnoise_eta1: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_getnoise_eta2(&ap, seed, 0);
-  }
-  print_results("poly_getnoise_eta2: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_ntt(&ap);
-  }
-  print_results("NTT: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_invntt_tomont(&ap);
-  }
-  print_results("INVNTT: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    polyvec_basemul_acc_montgomery(&ap, &matrix[0], &matrix[1]);
-  }
-  print_results("polyvec_basemul_acc_montgomery: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_tomsg(ct,&ap);
-  }
-  print_results("poly_tomsg: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_frommsg(&ap,ct);
-  }
-  print_results("poly_frommsg: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_compress(ct,&ap);
-  }
-  print_results("poly_compress: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    poly_decompress(&ap,ct);
-  }
-  print_results("poly_decompress: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    polyvec_compress(ct,&matrix[0]);
-  }
-  print_results("polyvec_compress: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    polyvec_decompress(&matrix[0],ct);
-  }
-  print_results("polyvec_decompress: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    indcpa_keypair_derand(pk, sk, coins32);
-  }
-  print_results("indcpa_keypair: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    indcpa_enc(ct, key, pk, seed);
+  for(j=1;j<argc;j++) {
+    if(j+1 < argc && !strcmp(argv[j], "--save"))
+      save = argv[++j];
+    else if(j+1 < argc && !strcmp(argv[j], "--compare"))
+      compare = argv[++j];
+    else if(j+1 < argc && !strcmp(argv[j], "--threshold"))
+      threshold = atof(argv[++j]);
+    else if(j+1 < argc && !strcmp(argv[j], "--alpha"))
+      alpha = atof(argv[++j]);
+    else {
+      usage(argv[0]);
+      return 2;
+    }
   }
-  print_results("indcpa_enc: ", t, NTESTS);
 
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    indcpa_dec(key, ct, sk);
-  }
-  print_results("indcpa_dec: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    crypto_kem_keypair_derand(pk, sk, coins64);
-  }
-  print_results("kyber_keypair_derand: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    crypto_kem_keypair(pk, sk);
-  }
-  print_results("kyber_keypair: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    crypto_kem_enc_derand(ct, key, pk, coins32);
-  }
-  print_results("kyber_encaps_derand: ", t, NTESTS);
-
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    crypto_kem_enc(ct, key, pk);
-  }
-  print_results("kyber_encaps: ", t, NTESTS);
+  randombytes(coins32, KYBER_SYMBYTES);
+  randombytes(coins64, 2*KYBER_SYMBYTES);
 
-  for(i=0;i<NTESTS;i++) {
-    t[i] = cpucycles();
-    crypto_kem_dec(key, ct, sk);
+#define MEASURE(name, call) \
+  for(i=0;i<NTESTS;i++) { \
+    t0 = cpucycles_start(); \
+    call; \
+    t[i] = cpucycles_stop() - t0; \
+  } \
+  perf_gate_add(name, t, NTESTS); \
+  print_results(name ": ", t, NTESTS);
+
+  PRIMITIVES(MEASURE)
+
+  if(save && perf_gate_save(save, IMPL))
+    return 2;
+
+  if(compare) {
+    regressions = perf_gate_compare(compare, IMPL, threshold/100, alpha);
+    if(regressions < 0)
+      return 2;
+    if(regressions > 0) {
+      printf("%d regression(s) beyond %.1f%% (alpha %g)\n", regressions, threshold, alpha);
+      return 1;
+    }
+    printf("no regressions beyond %.1f%% (alpha %g)\n", threshold, alpha);
   }
-  print_results("kyber_decaps: ", t, NTESTS);
 
   return 0;
 }
@@ -0,0 +1,248 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "../kem.h"
+#include "../stream.h"
+#include "../randombytes.h"
+
+#define NTESTS 100
+#define MAXIOV 16
+
+/* Feeds ct in pieces of up to maxchunk bytes (random lengths) */
+static int dec_chunked(uint8_t *ss, const uint8_t *ct, const uint8_t *sk, size_t maxchunk)
+{
+  size_t pos, n;
+  uint16_t r;
+  kem_dec_stream s;
+
+  crypto_kem_dec_init(&s, sk);
+  for(pos=0;pos<CRYPTO_CIPHERTEXTBYTES;pos+=n) {
+    randombytes((uint8_t *)&r, sizeof(r));
+    n = 1 + r % maxchunk;
+    if(n > CRYPTO_CIPHERTEXTBYTES - pos)
+      n = CRYPTO_CIPHERTEXTBYTES - pos;
+    if(crypto_kem_dec_update(&s, ct+pos, n))
+      return 1;
+  }
+  return crypto_kem_dec_final(ss, &s);
+}
+
+static int test_dec_stream(void)
+{
+  unsigned int i;
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t buf[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  uint8_t key_s[CRYPTO_BYTES];
+  const size_t maxchunk[] = {1, 7, 64, 500, CRYPTO_CIPHERTEXTBYTES};
+  uint8_t last;
+  uint16_t r;
+  kem_dec_stream s;
+
+  crypto_kem_keypair(pk, sk);
+  crypto_kem_enc(ct, key_b, pk);
+
+  /* Valid, then distorted in u and in v */
+  for(i=0;i<3;i++) {
+    if(i > 0) {
+      randombytes((uint8_t *)&r, sizeof(r));
+      if(i == 1)
+        ct[r % KYBER_POLYVECCOMPRESSEDBYTES] ^= 1 + (r >> 8) % 255;
+      else
+        ct[KYBER_POLYVECCOMPRESSEDBYTES + r % KYBER_POLYCOMPRESSEDBYTES] ^= 1 + (r >> 8) % 255;
+    }
+    crypto_kem_dec(key_a, ct, sk);
+    if((i == 0) != !memcmp(key_a, key_b, CRYPTO_BYTES)) {
+      printf("ERROR dec\n");
+      return 1;
+    }
+    for(r=0;r<sizeof(maxchunk)/sizeof(maxchunk[0]);r++) {
+      if(dec_chunked(key_s, ct, sk, maxchunk[r]) || memcmp(key_a, key_s, CRYPTO_BYTES)) {
+        printf("ERROR dec_update in pieces of up to %u bytes\n", (unsigned int)maxchunk[r]);
+        return 1;
+      }
+    }
+  }
+
+  /* Too much and too little input; the last byte changed */
+  last = ct[CRYPTO_CIPHERTEXTBYTES-1] ^ 1;
+  crypto_kem_dec_init(&s, sk);
+  if(crypto_kem_dec_update(&s, ct, CRYPTO_CIPHERTEXTBYTES-1) || !crypto_kem_dec_final(key_s, &s)
+     || crypto_kem_dec_update(&s, ct, 2) != -1 || crypto_kem_dec_update(&s, &last, 1)
+     || crypto_kem_dec_final(key_s, &s) || memcmp(key_s, key_a, CRYPTO_BYTES) == 0) {
+    printf("ERROR dec_update length checks\n");
+    return 1;
+  }
+
+  /* A distorted cipher text is fed and the buffer is then overwritten
+   * with the honest one: only the fed bytes may count */
+  crypto_kem_enc(ct, key_b, pk);
+  memcpy(buf, ct, CRYPTO_CIPHERTEXTBYTES);
+  randombytes((uint8_t *)&r, sizeof(r));
+  buf[r % CRYPTO_CIPHERTEXTBYTES] ^= 1 + (r >> 8) % 255;
+  crypto_kem_dec(key_a, buf, sk);
+  crypto_kem_dec_init(&s, sk);
+  if(crypto_kem_dec_update(&s, buf, 100) || crypto_kem_dec_update(&s, buf+100, CRYPTO_CIPHERTEXTBYTES-100))
+    return 1;
+  memcpy(buf, ct, CRYPTO_CIPHERTEXTBYTES);
+  if(crypto_kem_dec_final(key_s, &s) || memcmp(key_s, key_a, CRYPTO_BYTES)
+     || memcmp(key_s, key_b, CRYPTO_BYTES) == 0) {
+    printf("ERROR dec_final depends on more than the fed bytes\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+typedef struct {
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  size_t len;
+  unsigned int calls;
+  unsigned int stop;
+} collect;
+
+/* Appends the pieces; returns 7 on call number stop */
+static int sink(void *arg, const uint8_t *chunk, size_t len)
+{
+  collect *c = arg;
+  size_t expect = (c->calls < KYBER_K) ? KYBER_POLYVECCOMPRESSEDBYTES/KYBER_K : KYBER_POLYCOMPRESSEDBYTES;
+
+  if(++c->calls == c->stop)
+    return 7;
+  if(len != expect || len > CRYPTO_CIPHERTEXTBYTES - c->len)
+    return 1;
+  memcpy(c->ct + c->len, chunk, len);
+  c->len += len;
+  return 0;
+}
+
+static int test_enc_stream(void)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t coins[KYBER_SYMBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  uint8_t key_s[CRYPTO_BYTES] = {0};
+  collect c = {{0}, 0, 0, 0};
+
+  crypto_kem_keypair(pk, sk);
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_derand(ct, key_a, pk, coins);
+  if(crypto_kem_enc_stream_derand(key_b, pk, coins, sink, &c) || c.calls != KYBER_K+1
+     || c.len != CRYPTO_CIPHERTEXTBYTES || memcmp(ct, c.ct, CRYPTO_CIPHERTEXTBYTES)
+     || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR enc_stream_derand\n");
+    return 1;
+  }
+
+  memset(&c, 0, sizeof(c));
+  if(crypto_kem_enc_stream(key_b, pk, sink, &c) || c.len != CRYPTO_CIPHERTEXTBYTES) {
+    printf("ERROR enc_stream\n");
+    return 1;
+  }
+  crypto_kem_dec(key_a, c.ct, sk);
+  if(memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR enc_stream keys\n");
+    return 1;
+  }
+
+  /* Aborted by the sink */
+  memset(&c, 0, sizeof(c));
+  c.stop = 2;
+  if(crypto_kem_enc_stream(key_s, pk, sink, &c) != 7 || c.calls != 2 || key_s[0] || memcmp(key_s, key_s+1, CRYPTO_BYTES-1)) {
+    printf("ERROR enc_stream abort\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Splits buf into iovecs of random lengths, some of them empty */
+static int split(struct iovec iov[MAXIOV], uint8_t *buf, size_t len)
+{
+  int n;
+  size_t pos, m;
+  uint16_t r;
+
+  for(n=0,pos=0;n<MAXIOV-1 && pos<len;n++,pos+=m) {
+    randombytes((uint8_t *)&r, sizeof(r));
+    m = (r & 7) ? r % (len - pos + 1) : 0;
+    iov[n].iov_base = buf + pos;
+    iov[n].iov_len = m;
+  }
+  iov[n].iov_base = buf + pos;
+  iov[n].iov_len = len - pos;
+  return n + 1;
+}
+
+static int test_iov(void)
+{
+  int n;
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t ct_iov[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t coins[KYBER_SYMBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  struct iovec iov[MAXIOV];
+
+  crypto_kem_keypair(pk, sk);
+  randombytes(coins, KYBER_SYMBYTES);
+  crypto_kem_enc_derand(ct, key_a, pk, coins);
+
+  n = split(iov, pk, CRYPTO_PUBLICKEYBYTES);
+  if(crypto_kem_enc_iov_derand(ct_iov, key_b, iov, n, coins)
+     || memcmp(ct, ct_iov, CRYPTO_CIPHERTEXTBYTES) || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR enc_iov_derand\n");
+    return 1;
+  }
+  /* One byte too many, one too few */
+  iov[n-1].iov_len++;
+  iov[MAXIOV-1].iov_base = pk;
+  iov[MAXIOV-1].iov_len = CRYPTO_PUBLICKEYBYTES-1;
+  if(crypto_kem_enc_iov(ct_iov, key_b, iov, n) != -1 || crypto_kem_enc_iov(ct_iov, key_b, iov+MAXIOV-1, 1) != -1) {
+    printf("ERROR enc_iov accepted wrong length\n");
+    return 1;
+  }
+
+  n = split(iov, ct, CRYPTO_CIPHERTEXTBYTES);
+  if(crypto_kem_dec_iov(key_b, iov, n, sk) || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR dec_iov\n");
+    return 1;
+  }
+  ct[n % CRYPTO_CIPHERTEXTBYTES] ^= 0x10;
+  crypto_kem_dec(key_a, ct, sk);
+  if(crypto_kem_dec_iov(key_b, iov, n, sk) || memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR dec_iov of distorted cipher text\n");
+    return 1;
+  }
+  iov[n-1].iov_len++;
+  iov[MAXIOV-1].iov_base = ct;
+  iov[MAXIOV-1].iov_len = CRYPTO_CIPHERTEXTBYTES-1;
+  if(crypto_kem_dec_iov(key_b, iov, n, sk) != -1 || crypto_kem_dec_iov(key_b, iov+MAXIOV-1, 1, sk) != -1) {
+    printf("ERROR dec_iov accepted wrong length\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  unsigned int i;
+
+  for(i=0;i<NTESTS;i++)
+    if(test_dec_stream() || test_enc_stream() || test_iov())
+      return 1;
+
+  printf("stream: %d cipher texts OK\n", NTESTS);
+  return 0;
+}
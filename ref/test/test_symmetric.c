@@ -0,0 +1,120 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../kem.h"
+#include "../params.h"
+#include "../symmetric.h"
+#include "../randombytes.h"
+#include "cpucycles.h"
+#include "speed_print.h"
+
+#define NTESTS 1000
+#define NCHECKS 100
+
+/* Checks every compiled-in symmetric backend against the portable one and
+ * benchmarks them side by side. Build with -DKYBER_SYMMETRIC_OPENSSL and
+ * -lcrypto (make symmetric) to include OpenSSL. Names given on the command
+ * line restrict the run to those backends. */
+
+uint64_t t[NTESTS];
+
+static int check_backend(const symmetric_backend *b, const symmetric_backend *ref)
+{
+  unsigned int i;
+  size_t inlen;
+  uint8_t in[KYBER_CIPHERTEXTBYTES];
+  uint8_t key[KYBER_SYMBYTES];
+  uint8_t out0[KYBER_ETA1*KYBER_N/4];
+  uint8_t out1[KYBER_ETA1*KYBER_N/4];
+
+  for(i=0;i<NCHECKS;i++) {
+    randombytes(in, sizeof(in));
+    randombytes(key, sizeof(key));
+    inlen = in[0] + in[1];
+
+    (*b->hash_h)(out0, in, inlen);
+    (*ref->hash_h)(out1, in, inlen);
+    if(memcmp(out0, out1, 32))
+      return -1;
+
+    (*b->hash_g)(out0, in, inlen);
+    (*ref->hash_g)(out1, in, inlen);
+    if(memcmp(out0, out1, 64))
+      return -1;
+
+    (*b->prf)(out0, sizeof(out0), key, (uint8_t)i);
+    (*ref->prf)(out1, sizeof(out1), key, (uint8_t)i);
+    if(memcmp(out0, out1, sizeof(out0)))
+      return -1;
+
+    (*b->rkprf)(out0, key, in);
+    (*ref->rkprf)(out1, key, in);
+    if(memcmp(out0, out1, KYBER_SSBYTES))
+      return -1;
+  }
+
+  return 0;
+}
+
+static int selected(const char *name, int argc, char **argv)
+{
+  int i;
+
+  if(argc < 2)
+    return 1;
+  for(i=1;i<argc;i++)
+    if(!strcmp(argv[i], name))
+      return 1;
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int i;
+  size_t j;
+  uint64_t t0;
+  const symmetric_backend *b, *ref = symmetric_backend_get(0);
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key[CRYPTO_BYTES];
+  uint8_t coins32[KYBER_SYMBYTES];
+  uint8_t coins64[2*KYBER_SYMBYTES];
+  uint8_t buf[KYBER_ETA1*KYBER_N/4];
+
+  randombytes(coins32, KYBER_SYMBYTES);
+  randombytes(coins64, 2*KYBER_SYMBYTES);
+  crypto_kem_keypair(pk, sk);
+  crypto_kem_enc(ct, key, pk);
+
+  for(j=0;(b = symmetric_backend_get(j)) != NULL;j++) {
+    if(!selected(b->name, argc, argv))
+      continue;
+
+    if(check_backend(b, ref)) {
+      fprintf(stderr, "ERROR backend %s differs from %s\n", b->name, ref->name);
+      return 1;
+    }
+    symmetric_backend_select(b->name);
+    printf("backend: %s\n\n", b->name);
+
+#define MEASURE(name, call) \
+    for(i=0;i<NTESTS;i++) { \
+      t0 = cpucycles_start(); \
+      call; \
+      t[i] = cpucycles_stop() - t0; \
+    } \
+    print_results(name ": ", t, NTESTS);
+
+    MEASURE("hash_h (pk)", hash_h(buf, pk, KYBER_PUBLICKEYBYTES))
+    MEASURE("hash_g", hash_g(buf, coins64, 2*KYBER_SYMBYTES))
+    MEASURE("prf (eta1)", prf(buf, sizeof(buf), coins32, 0))
+    MEASURE("rkprf", rkprf(key, coins32, ct))
+    MEASURE("kyber_keypair_derand", crypto_kem_keypair_derand(pk, sk, coins64))
+    MEASURE("kyber_encaps_derand", crypto_kem_enc_derand(ct, key, pk, coins32))
+    MEASURE("kyber_decaps", crypto_kem_dec(key, ct, sk))
+  }
+
+  return 0;
+}
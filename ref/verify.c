@@ -73,3 +73,21 @@ void cmov_int16(int16_t *r, int16_t v, uint16_t b)
   b = -b;
   *r ^= b & ((*r) ^ v);
 }
+
+/*************************************************
+* Name:        wipe
+*
+* Description: Overwrite len bytes at p with zeros, e.g. secrets on the
+*              stack before returning; the volatile stores are not
+*              removed as dead by the compiler.
+*
+* Arguments:   void *p:    pointer to byte array
+*              size_t len: Amount of bytes to be cleared
+**************************************************/
+void wipe(void *p, size_t len)
+{
+  volatile uint8_t *v = p;
+
+  while(len--)
+    *v++ = 0;
+}
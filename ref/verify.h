@@ -14,4 +14,7 @@ void cmov(uint8_t *r, const uint8_t *x, size_t len, uint8_t b);
 #define cmov_int16 KYBER_NAMESPACE(cmov_int16)
 void cmov_int16(int16_t *r, int16_t v, uint16_t b);
 
+#define wipe KYBER_NAMESPACE(wipe)
+void wipe(void *p, size_t len);
+
 #endif
@@ -1,8 +1,38 @@
 from setuptools import setup, Extension
 
+KYBER_SOURCES = [
+    "ref/kem.c",
+    "ref/indcpa.c",
+    "ref/polyvec.c",
+    "ref/poly.c",
+    "ref/ntt.c",
+    "ref/cbd.c",
+    "ref/reduce.c",
+    "ref/verify.c",
+    "ref/fips202.c",
+    "ref/symmetric-shake.c",
+    "ref/symmetric-backend.c",
+    "ref/randombytes.c",
+]
+
+
+def kyber_extension(k, name):
+    # One module per parameter set; the ref code is namespaced per KYBER_K
+    return Extension(
+        name,
+        ["kybermodule.c"] + KYBER_SOURCES,
+        include_dirs=["ref"],
+        define_macros=[("KYBER_K", str(k)), ("KYBER_MODULE", name)],
+        extra_compile_args=["-O3", "-fomit-frame-pointer"],
+    )
+
+
 setup(
     name="cycles",
     ext_modules=[
-        Extension("cycles", ["cycles.c"])
+        Extension("cycles", ["cycles.c"]),
+        kyber_extension(2, "kyber512"),
+        kyber_extension(3, "kyber768"),
+        kyber_extension(4, "kyber1024"),
     ]
 )
@@ -1,5 +1,4 @@
-import ctypes
-import os
+import importlib
 import cycles  # Your custom rdtsc module
 
 print("Initial CPU Cycle Counter:", cycles.rdtsc())
@@ -8,11 +7,11 @@ print("Initial CPU Cycle Counter:", cycles.rdtsc())
 KYBER_MODE = "512"  # Options: "512", "768", "1024"
 ### ========================================= ###
 
-# Configuration map
+# Extension modules built by setup.py (python3 setup.py build_ext --inplace)
 MODES = {
-    "512": (800, 1632, 768, 32, "libkyber512_universal.dylib"),
-    "768": (1184, 2400, 1088, 32, "libkyber768_universal.dylib"),
-    "1024": (1568, 3168, 1568, 32, "libkyber1024.dylib"),
+    "512": "kyber512",
+    "768": "kyber768",
+    "1024": "kyber1024",
 }
 
 print("Mode:", KYBER_MODE)
@@ -21,51 +20,44 @@ print("Mode:", KYBER_MODE)
 if KYBER_MODE not in MODES:
     raise ValueError("Invalid KYBER_MODE. Use '512', '768', or '1024'.")
 
-PK_LEN, SK_LEN, CT_LEN, SS_LEN, libname = MODES[KYBER_MODE]
-
-# Load the appropriate shared library
-lib = ctypes.CDLL(os.path.abspath(libname))
-
-# Define ctypes pointer type
-Uint8Array = ctypes.POINTER(ctypes.c_ubyte)
-
-# Set function signatures
-lib.keypair.argtypes = [Uint8Array, Uint8Array]
-lib.keypair.restype = None
-
-lib.encapsulate.argtypes = [Uint8Array, Uint8Array, Uint8Array]
-lib.encapsulate.restype = None
-
-lib.decapsulate.argtypes = [Uint8Array, Uint8Array, Uint8Array]
-lib.decapsulate.restype = None
-
-# Allocate buffers
-pk = (ctypes.c_ubyte * PK_LEN)()
-sk = (ctypes.c_ubyte * SK_LEN)()
-ct = (ctypes.c_ubyte * CT_LEN)()
-ss1 = (ctypes.c_ubyte * SS_LEN)()
-ss2 = (ctypes.c_ubyte * SS_LEN)()
+kyber = importlib.import_module(MODES[KYBER_MODE])
 
 # --- Keypair Timing ---
 start_cycles = cycles.rdtsc()
-lib.keypair(pk, sk)
+pk, sk = kyber.keypair()
 end_cycles = cycles.rdtsc()
 print(f"[Cycles] Keypair: {end_cycles - start_cycles} cycles")
 
 # --- Encapsulation Timing ---
 start_cycles = cycles.rdtsc()
-lib.encapsulate(pk, ct, ss1)
+ct, ss1 = kyber.enc(pk)
 end_cycles = cycles.rdtsc()
 print(f"[Cycles] Encapsulation: {end_cycles - start_cycles} cycles")
 
 # --- Decapsulation Timing ---
 start_cycles = cycles.rdtsc()
-lib.decapsulate(ct, sk, ss2)
+ss2 = kyber.dec(ct, sk)
 end_cycles = cycles.rdtsc()
 print(f"[Cycles] Decapsulation: {end_cycles - start_cycles} cycles")
 
+# --- Batch round trip on preallocated buffers ---
+BATCH = 16
+pks = bytearray(BATCH * kyber.PUBLICKEYBYTES)
+sks = bytearray(BATCH * kyber.SECRETKEYBYTES)
+cts = bytearray(BATCH * kyber.CIPHERTEXTBYTES)
+sss1 = bytearray(BATCH * kyber.BYTES)
+sss2 = bytearray(BATCH * kyber.BYTES)
+
+start_cycles = cycles.rdtsc()
+kyber.keypair_batch(pks, sks)
+kyber.enc_batch(cts, sss1, pks)
+kyber.dec_batch(sss2, cts, sks)
+end_cycles = cycles.rdtsc()
+print(f"[Cycles] Batch of {BATCH} round trips: {(end_cycles - start_cycles) // BATCH} cycles each")
+
 # Output results
-print(f"\nKyber{KYBER_MODE}")
-print("Shared Secret 1:", bytes(ss1).hex())
-print("Shared Secret 2:", bytes(ss2).hex())
-print("Match:", bytes(ss1) == bytes(ss2))
+print(f"\n{kyber.ALGNAME}")
+print("Shared Secret 1:", ss1.hex())
+print("Shared Secret 2:", ss2.hex())
+print("Match:", ss1 == ss2)
+print("Batch Match:", sss1 == sss2)